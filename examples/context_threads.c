@@ -0,0 +1,83 @@
+// Runs the same script in N contexts on N threads and checks every result.
+// Each thread does the same work as the single-threaded run, so on a machine
+// with N free cores the threaded run should take about as long as one run.
+//
+//   gcc -O2 -std=gnu11 -Isrc examples/context_threads.c $(ls src/*.c | grep -v NevoidX.c) -o build/context_threads -lm -lpthread
+//   build/context_threads [threads] [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "NVXContext.h"
+#include "NVXScript.h"
+
+static const char *script_fmt =
+    "def.var=I,S,T\n"
+    "S=0\n"
+    "for I=1 to %d {\n"
+    "    T=math(I*2+1)\n"
+    "    if T > 10 && I != 3 { S=math(S+T) }\n"
+    "}\n";
+
+static char script[512];
+static size_t script_len;
+static double expected;
+
+typedef struct { pthread_t tid; int ok; } Worker;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *run_one(void *arg) {
+    Worker *w = arg;
+    NVXContext *ctx = nvx_context_new();
+    double s = -1;
+    if (ctx) {
+        nvx_run_source(ctx, script, script_len);
+        nvx_get_variable_number(ctx, "S", &s);
+        nvx_context_free(ctx);
+    }
+    w->ok = s == expected;
+    return NULL;
+}
+
+// wall time of n threads running the script at once; -1 if a result is wrong
+static double run_threads(int n) {
+    Worker *ws = calloc((size_t)n, sizeof(Worker));
+    if (!ws) return -1;
+    double t0 = now();
+    for (int i = 0; i < n; ++i) pthread_create(&ws[i].tid, NULL, run_one, &ws[i]);
+    int ok = 1;
+    for (int i = 0; i < n; ++i) {
+        pthread_join(ws[i].tid, NULL);
+        ok &= ws[i].ok;
+    }
+    double t = now() - t0;
+    free(ws);
+    return ok ? t : -1;
+}
+
+int main(int argc, char *argv[]) {
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+    int iters = argc > 2 ? atoi(argv[2]) : 200000;
+    if (threads < 1 || iters < 1) return 1;
+    script_len = (size_t)snprintf(script, sizeof(script), script_fmt, iters);
+    for (int i = 1; i <= iters; ++i) {
+        if (2 * i + 1 > 10 && i != 3) expected += 2 * i + 1;
+    }
+    double one = run_threads(1);
+    double all = run_threads(threads);
+    if (one < 0 || all < 0) {
+        printf("FAIL: a context computed a wrong result\n");
+        return 1;
+    }
+    printf("1 context : %.3f s\n", one);
+    printf("%d contexts on %d threads: %.3f s (%.2fx the work in %.2fx the time)\n",
+           threads, threads, all, (double)threads, all / one);
+    return 0;
+}
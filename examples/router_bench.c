@@ -0,0 +1,76 @@
+// Lookup cost of NVXRouter against a linear strcmp scan of the same paths,
+// for a growing number of routes. Half the routes carry a :id parameter;
+// lookups cycle over every route so each one is hit equally often.
+//
+//   gcc -O2 -std=gnu11 -Isrc examples/router_bench.c src/NVXRouter.c -o build/router_bench
+//   build/router_bench [lookups]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "NVXRouter.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// the scan the server used before the router: exact paths only
+static int linear_find(char **paths, int n, const char *path) {
+    for (int i = 0; i < n; ++i) {
+        if (strcmp(paths[i], path) == 0) return i;
+    }
+    return -1;
+}
+
+static int bench(int routes, long lookups) {
+    NVXRouter *r = nvx_router_new();
+    char **patterns = calloc((size_t)routes, sizeof(char *));
+    char **paths = calloc((size_t)routes, sizeof(char *));
+    if (!r || !patterns || !paths) return -1;
+    for (int i = 0; i < routes; ++i) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), i % 2 ? "/api/v1/res%d/:id" : "/api/v1/res%d/list", i);
+        patterns[i] = strdup(buf);
+        snprintf(buf, sizeof(buf), i % 2 ? "/api/v1/res%d/42" : "/api/v1/res%d/list", i);
+        paths[i] = strdup(buf);
+        if (nvx_router_add(r, "GET", patterns[i], patterns[i]) != 0) return -1;
+    }
+    NVXParams params;
+    long hits = 0;
+    double t0 = now();
+    for (long k = 0; k < lookups; ++k) {
+        const char *p = paths[k % routes];
+        if (nvx_router_find(r, "GET", 3, p, strlen(p), &params)) hits++;
+    }
+    double radix = (now() - t0) / (double)lookups * 1e9;
+    // the linear scan compares against the concrete paths, which favours it
+    t0 = now();
+    for (long k = 0; k < lookups; ++k) {
+        if (linear_find(paths, routes, paths[k % routes]) >= 0) hits++;
+    }
+    double linear = (now() - t0) / (double)lookups * 1e9;
+    printf("%7d  %8.0f ns  %10.0f ns\n", routes, radix, linear);
+    for (int i = 0; i < routes; ++i) { free(patterns[i]); free(paths[i]); }
+    free(patterns);
+    free(paths);
+    nvx_router_free(r);
+    return hits == 2 * lookups ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+    long lookups = argc > 1 ? atol(argv[1]) : 2000000;
+    if (lookups < 1) return 1;
+    printf(" routes     radix  linear strcmp\n");
+    int sizes[] = { 10, 100, 1000 };
+    for (int i = 0; i < 3; ++i) {
+        if (bench(sizes[i], lookups) != 0) {
+            printf("FAIL: a lookup missed its route\n");
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+// Closed-loop load against nvx_run_server: C client threads each send one
+// request per connection (as the old blocking loop required), wait for the
+// reply, and repeat for a fixed time. /fast answers at once, /slow blocks for
+// 2 ms first, as a handler doing I/O would. Only nvx_register_route and
+// nvx_run_server are used, so the same driver also builds against an older
+// tree (e.g. `git archive <commit> src | tar -x -C /tmp/old`) for comparison.
+//
+//   gcc -O2 -std=gnu11 -Isrc examples/server_load.c $(ls src/*.c | grep -v NevoidX.c) -o build/server_load -lm -lpthread
+//   build/server_load [clients] [seconds] [port]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+
+#include "NVXNet.h"
+
+static const char *port = "18080";
+static volatile int running = 1;
+
+static void fast(const char *body, char *resp, size_t sz) {
+    (void)body;
+    snprintf(resp, sz, "ok");
+}
+
+static void slow(const char *body, char *resp, size_t sz) {
+    (void)body;
+    struct timespec ts = { 0, 2000000 };
+    nanosleep(&ts, NULL);
+    snprintf(resp, sz, "ok");
+}
+
+static void *server_main(void *arg) {
+    (void)arg;
+    nvx_run_server(port);
+    return NULL;
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// one request on a fresh connection; 0 once a reply has been read
+static int request(const struct addrinfo *ai, const char *req) {
+    int s = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (s < 0) return -1;
+    int rc = -1;
+    if (connect(s, ai->ai_addr, ai->ai_addrlen) == 0 && send(s, req, strlen(req), 0) == (ssize_t)strlen(req)) {
+        char buf[1024];
+        ssize_t n, got = 0;
+        while ((n = recv(s, buf, sizeof(buf), 0)) > 0) got += n;
+        if (got > 0 && strncmp(buf, "HTTP/1.", 7) == 0) rc = 0;
+    }
+    close(s);
+    return rc;
+}
+
+typedef struct { const struct addrinfo *ai; const char *req; long done, failed; pthread_t tid; } Client;
+
+static void *client_main(void *arg) {
+    Client *c = arg;
+    while (running) {
+        if (request(c->ai, c->req) == 0) c->done++;
+        else c->failed++;
+    }
+    return NULL;
+}
+
+static void run(const struct addrinfo *ai, const char *path, int clients, int seconds) {
+    char req[128];
+    snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n", path);
+    Client *cs = calloc((size_t)clients, sizeof(Client));
+    if (!cs) return;
+    running = 1;
+    double t0 = now();
+    for (int i = 0; i < clients; ++i) {
+        cs[i].ai = ai;
+        cs[i].req = req;
+        pthread_create(&cs[i].tid, NULL, client_main, &cs[i]);
+    }
+    sleep((unsigned)seconds);
+    running = 0;
+    long done = 0, failed = 0;
+    for (int i = 0; i < clients; ++i) {
+        pthread_join(cs[i].tid, NULL);
+        done += cs[i].done;
+        failed += cs[i].failed;
+    }
+    double t = now() - t0;
+    printf("%-6s %3d clients: %8.0f req/s (%ld failed)\n", path, clients, (double)done / t, failed);
+    free(cs);
+}
+
+int main(int argc, char *argv[]) {
+    int clients = argc > 1 ? atoi(argv[1]) : 16;
+    int seconds = argc > 2 ? atoi(argv[2]) : 5;
+    if (argc > 3) port = argv[3];
+    if (clients < 1 || seconds < 1) return 1;
+    nvx_register_route("/fast", fast);
+    nvx_register_route("/slow", slow);
+    pthread_t t;
+    pthread_create(&t, NULL, server_main, NULL);
+    pthread_detach(t);
+    sleep(1); // let the server bind
+    struct addrinfo hints, *ai;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo("127.0.0.1", port, &hints, &ai) != 0) return 1;
+    run(ai, "/fast", clients, seconds);
+    run(ai, "/slow", clients, seconds);
+    freeaddrinfo(ai);
+    return 0; // the server thread ends with the process
+}
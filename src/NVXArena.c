@@ -0,0 +1,127 @@
+#include "NVXArena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// chunk sizes start small (a program's string pool is often tiny) and double
+// up to ARENA_CHUNK_MAX
+#define ARENA_CHUNK_MIN 1024
+#define ARENA_CHUNK_MAX (64 * 1024)
+#define ARENA_ALIGN 16
+
+struct NVXArenaChunk {
+    NVXArenaChunk *next;
+    size_t size, used;
+    _Alignas(ARENA_ALIGN) unsigned char data[];
+};
+
+_Thread_local NVXAllocStats nvx_alloc_stats;
+
+void *nvx_malloc(size_t n) {
+    nvx_alloc_stats.heap_allocs++;
+    return malloc(n);
+}
+
+void *nvx_calloc(size_t count, size_t n) {
+    nvx_alloc_stats.heap_allocs++;
+    return calloc(count, n);
+}
+
+void *nvx_realloc(void *p, size_t n) {
+    nvx_alloc_stats.heap_allocs++;
+    return realloc(p, n);
+}
+
+char *nvx_strdup(const char *s) {
+    size_t n = strlen(s) + 1;
+    char *copy = nvx_malloc(n);
+    if (copy) memcpy(copy, s, n);
+    return copy;
+}
+
+// a spare chunk that fits n bytes, else a new one
+static NVXArenaChunk *take_chunk(NVXArena *a, size_t n) {
+    for (NVXArenaChunk **pp = &a->spare; *pp; pp = &(*pp)->next) {
+        if ((*pp)->size >= n) {
+            NVXArenaChunk *c = *pp;
+            *pp = c->next;
+            c->used = 0;
+            return c;
+        }
+    }
+    size_t size = a->head ? a->head->size * 2 : ARENA_CHUNK_MIN;
+    if (size > ARENA_CHUNK_MAX) size = ARENA_CHUNK_MAX;
+    if (size < n) size = n;
+    NVXArenaChunk *c = nvx_malloc(sizeof(NVXArenaChunk) + size);
+    if (!c) return NULL;
+    c->size = size;
+    c->used = 0;
+    nvx_alloc_stats.arena_chunks++;
+    nvx_alloc_stats.arena_bytes += size;
+    return c;
+}
+
+void *nvx_arena_alloc(NVXArena *a, size_t n) {
+    n = (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (!n) n = ARENA_ALIGN;
+    NVXArenaChunk *c = a->head;
+    if (!c || c->size - c->used < n) {
+        c = take_chunk(a, n);
+        if (!c) return NULL;
+        c->next = a->head;
+        a->head = c;
+    }
+    void *p = c->data + c->used;
+    c->used += n;
+    nvx_alloc_stats.arena_allocs++;
+    return p;
+}
+
+char *nvx_arena_strndup(NVXArena *a, const char *s, size_t n) {
+    char *copy = nvx_arena_alloc(a, n + 1);
+    if (!copy) return NULL;
+    memcpy(copy, s, n);
+    copy[n] = '\0';
+    return copy;
+}
+
+NVXArenaMark nvx_arena_mark(NVXArena *a) {
+    NVXArenaMark m = { a->head, a->head ? a->head->used : 0 };
+    return m;
+}
+
+void nvx_arena_release(NVXArena *a, NVXArenaMark m) {
+    while (a->head && a->head != m.chunk) {
+        NVXArenaChunk *c = a->head;
+        a->head = c->next;
+        c->next = a->spare;
+        a->spare = c;
+    }
+    if (a->head) a->head->used = m.used;
+}
+
+void nvx_arena_reset(NVXArena *a) {
+    NVXArenaMark none = { NULL, 0 };
+    nvx_arena_release(a, none);
+}
+
+static void free_chunks(NVXArenaChunk *c) {
+    while (c) {
+        NVXArenaChunk *next = c->next;
+        nvx_alloc_stats.arena_bytes -= c->size;
+        free(c);
+        c = next;
+    }
+}
+
+void nvx_arena_destroy(NVXArena *a) {
+    free_chunks(a->head);
+    free_chunks(a->spare);
+    a->head = a->spare = NULL;
+}
+
+void nvx_alloc_report(void) {
+    printf("heap allocations : %llu\n", nvx_alloc_stats.heap_allocs);
+    printf("arena allocations: %llu\n", nvx_alloc_stats.arena_allocs);
+    printf("arena chunks     : %llu (%zu bytes held)\n", nvx_alloc_stats.arena_chunks, nvx_alloc_stats.arena_bytes);
+}
@@ -0,0 +1,55 @@
+#ifndef NVX_ARENA_H
+#define NVX_ARENA_H
+
+#include <stddef.h>
+
+// bump allocator for interpreter-internal memory. Allocations are released
+// together: back to a mark (LIFO scratch use) or all at once by a reset.
+// Released chunks are kept and reused, so a steady loop that allocates and
+// releases scratch memory stops touching the heap after its first pass.
+
+typedef struct NVXArenaChunk NVXArenaChunk;
+
+typedef struct {
+    NVXArenaChunk *head;  // chunk being filled, older chunks follow
+    NVXArenaChunk *spare; // released chunks waiting for reuse
+} NVXArena;
+
+typedef struct { NVXArenaChunk *chunk; size_t used; } NVXArenaMark;
+
+#define NVX_ARENA_INIT { NULL, NULL }
+
+// n bytes aligned for any type; NULL on allocation failure
+void *nvx_arena_alloc(NVXArena *a, size_t n);
+// NUL-terminated copy of the first n bytes of s
+char *nvx_arena_strndup(NVXArena *a, const char *s, size_t n);
+
+NVXArenaMark nvx_arena_mark(NVXArena *a);
+// drop everything allocated since m
+void nvx_arena_release(NVXArena *a, NVXArenaMark m);
+// drop everything, keeping the chunks for reuse
+void nvx_arena_reset(NVXArena *a);
+// give all chunks back to the heap
+void nvx_arena_destroy(NVXArena *a);
+
+// heap allocation made by the interpreter core, counted in nvx_alloc_stats
+void *nvx_malloc(size_t n);
+void *nvx_calloc(size_t count, size_t n);
+void *nvx_realloc(void *p, size_t n);
+char *nvx_strdup(const char *s);
+
+typedef struct {
+    unsigned long long heap_allocs;  // nvx_malloc/calloc/realloc/strdup calls, chunks included
+    unsigned long long arena_allocs; // nvx_arena_alloc calls
+    unsigned long long arena_chunks; // chunks taken from the heap
+    size_t arena_bytes;              // bytes held in chunks
+} NVXAllocStats;
+
+// counted per thread, so interpreters running in parallel do not share a
+// contended counter; the shell reports its own thread's
+extern _Thread_local NVXAllocStats nvx_alloc_stats;
+
+// print the counters (shell `mem`)
+void nvx_alloc_report(void);
+
+#endif // NVX_ARENA_H
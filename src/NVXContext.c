@@ -0,0 +1,36 @@
+#include "NVXContext.h"
+#include <stdlib.h>
+
+static NVXContext default_context = { .delay = -1 };
+
+NVXContext *nvx_default_context(void) {
+    return &default_context;
+}
+
+NVXContext *nvx_context_new(void) {
+    NVXContext *ctx = nvx_calloc(1, sizeof(NVXContext));
+    if (ctx) ctx->delay = -1;
+    return ctx;
+}
+
+NVXContext *nvx_context_clone(NVXContext *src) {
+    NVXContext *ctx = nvx_context_new();
+    if (ctx && !nvx_vars_copy(ctx, src)) {
+        nvx_context_free(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+void nvx_context_free(NVXContext *ctx) {
+    if (!ctx) return;
+    nvx_vars_destroy(ctx);
+    nvx_expr_cache_destroy(ctx);
+    nvx_arena_destroy(&ctx->arena);
+    if (ctx == &default_context) {
+        NVXContext fresh = { .delay = -1 };
+        *ctx = fresh;
+    } else {
+        free(ctx);
+    }
+}
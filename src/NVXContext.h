@@ -0,0 +1,37 @@
+#ifndef NVX_CONTEXT_H
+#define NVX_CONTEXT_H
+
+#include "NVXVars.h"
+#include "NVXArena.h"
+
+// One interpreter instance: everything a running script reads or changes.
+// Contexts share nothing, so each may run on its own thread without locks; a
+// single context must not be used by two threads at once. Programs and
+// expressions compiled in a context bind its variable slots and run only there.
+struct NVXContext {
+    Variable *vars; int var_count, var_cap;  // slots, indexed by interned name
+    int *var_index; size_t var_index_size;   // name -> slot, see NVXVars.c
+    struct NVXNamedBlock *blocks; int block_count, block_cap;
+    unsigned block_version;
+    int delay;        // -1 = no delay, 0 = wait for input, >0 seconds delay between statements
+    NVXArena arena;   // scratch memory of the current run: reset when a run ends
+    struct NVXExprCacheEntry *exprs; int exprs_used; // compiled expressions by text (NVXMath.c)
+};
+
+// NULL on allocation failure
+NVXContext *nvx_context_new(void);
+void nvx_context_free(NVXContext *ctx);
+
+// a new context holding copies of src's variables and named blocks, the
+// blocks compiled afresh in it; NULL on failure. src is only read.
+NVXContext *nvx_context_clone(NVXContext *src);
+
+// the context behind the name-based API (set_variable, run_file, ...) and the shell
+NVXContext *nvx_default_context(void);
+
+// release what the modules keep in ctx (used by nvx_context_free)
+void nvx_vars_destroy(NVXContext *ctx);
+int nvx_vars_copy(NVXContext *dst, NVXContext *src); // used by nvx_context_clone
+void nvx_expr_cache_destroy(NVXContext *ctx);
+
+#endif // NVX_CONTEXT_H
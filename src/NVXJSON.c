@@ -97,3 +97,83 @@ int nvx_json_get(const char *json, const char *key, char *out, size_t out_size)
         return 1;
     }
 }
+
+enum { JS_SCAN, JS_STRING, JS_COLON, JS_VALUE, JS_VSTRING, JS_VNESTED, JS_VSCALAR, JS_DONE };
+
+void nvx_json_stream_init(NVXJsonStream *s, const char *key, char *out, size_t out_size) {
+    memset(s, 0, sizeof(*s));
+    strncpy(s->key, key, sizeof(s->key) - 1);
+    s->key_len = strlen(s->key);
+    s->out = out;
+    s->out_size = out_size;
+    if (out && out_size) out[0] = '\0';
+}
+
+static void js_capture(NVXJsonStream *s, char ch) {
+    if (s->out_len + 1 < s->out_size) {
+        s->out[s->out_len++] = ch;
+        s->out[s->out_len] = '\0';
+    }
+}
+
+int nvx_json_stream_feed(NVXJsonStream *s, const char *data, size_t len) {
+    for (size_t i = 0; i < len && s->state != JS_DONE; ++i) {
+        char ch = data[i];
+        switch (s->state) {
+        case JS_SCAN:
+            if (ch == '"') { s->state = JS_STRING; s->key_pos = 0; s->key_match = 1; s->escape = 0; }
+            break;
+        case JS_STRING: // any string; compared raw against the key as it goes
+            if (!s->escape && ch == '"') {
+                s->state = (s->key_match && s->key_pos == s->key_len) ? JS_COLON : JS_SCAN;
+                break;
+            }
+            s->escape = !s->escape && ch == '\\';
+            if (s->key_pos < s->key_len && ch == s->key[s->key_pos]) s->key_pos++;
+            else s->key_match = 0;
+            break;
+        case JS_COLON:
+            if (isspace((unsigned char)ch)) break;
+            if (ch == ':') { s->state = JS_VALUE; break; }
+            // the matching string was a value, not a key
+            s->state = JS_SCAN;
+            --i;
+            break;
+        case JS_VALUE:
+            if (isspace((unsigned char)ch)) break;
+            if (ch == '"') { s->state = JS_VSTRING; s->escape = 0; }
+            else if (ch == '{' || ch == '[') { s->state = JS_VNESTED; s->depth = 1; s->in_string = 0; s->escape = 0; js_capture(s, ch); }
+            else { s->state = JS_VSCALAR; js_capture(s, ch); }
+            break;
+        case JS_VSTRING:
+            if (!s->escape && ch == '"') { s->state = JS_DONE; break; }
+            s->escape = !s->escape && ch == '\\';
+            js_capture(s, ch);
+            break;
+        case JS_VNESTED:
+            js_capture(s, ch);
+            if (s->in_string) {
+                if (!s->escape && ch == '"') s->in_string = 0;
+                s->escape = !s->escape && ch == '\\';
+            } else if (ch == '"') {
+                s->in_string = 1;
+                s->escape = 0;
+            } else if (ch == '{' || ch == '[') {
+                s->depth++;
+            } else if ((ch == '}' || ch == ']') && --s->depth == 0) {
+                s->state = JS_DONE;
+            }
+            break;
+        case JS_VSCALAR:
+            if (ch == ',' || ch == '}' || ch == ']' || isspace((unsigned char)ch)) s->state = JS_DONE;
+            else js_capture(s, ch);
+            break;
+        }
+    }
+    return s->state == JS_DONE;
+}
+
+int nvx_json_stream_finish(NVXJsonStream *s) {
+    if (s->state == JS_VSCALAR) s->state = JS_DONE; // a bare scalar document may end without a delimiter
+    return s->state == JS_DONE;
+}
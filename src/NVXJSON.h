@@ -16,4 +16,23 @@ size_t nvx_json_object(char *out, size_t out_size, const char **pairs);
 // parse flat object, find value for given key; returns 1 if found, 0 otherwise
 int nvx_json_get(const char *json, const char *key, char *out, size_t out_size);
 
+// incremental lookup of one key in a document that arrives in pieces (e.g.
+// an HTTP response body); the value is captured like nvx_json_get does
+typedef struct {
+    char key[128];
+    size_t key_len, key_pos;
+    int key_match;
+    char *out;
+    size_t out_size, out_len;
+    int state, escape, depth, in_string;
+} NVXJsonStream;
+
+void nvx_json_stream_init(NVXJsonStream *s, const char *key, char *out, size_t out_size);
+
+// scan the next piece; returns 1 once the value is complete (further input is ignored)
+int nvx_json_stream_feed(NVXJsonStream *s, const char *data, size_t len);
+
+// end of input; returns 1 if the key was found
+int nvx_json_stream_finish(NVXJsonStream *s);
+
 #endif // NVX_JSON_H
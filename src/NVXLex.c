@@ -0,0 +1,163 @@
+#include "NVXLex.h"
+#include "NVXArena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+void nvx_lex_init(NVXLexer *lx, const char *text, size_t len) {
+    lx->pos = text;
+    lx->end = text + len;
+}
+
+static int is_ident_start(char c) { return isalpha((unsigned char)c) || c == '_'; }
+static int is_ident_char(char c) { return isalnum((unsigned char)c) || c == '_'; }
+
+NVXLexToken nvx_lex_next(NVXLexer *lx) {
+    const char *p = lx->pos, *end = lx->end;
+    while (p < end && isspace((unsigned char)*p)) p++;
+    NVXLexToken t = { LEX_END, p, 0 };
+    if (p >= end || *p == '\0') { lx->pos = p; return t; }
+    const char *s = p;
+    char c = *p;
+    if (is_ident_start(c)) {
+        p++;
+        // a '.' belongs to the name only when another name character follows
+        while (p < end && (is_ident_char(*p) || (*p == '.' && p + 1 < end && is_ident_start(p[1])))) p++;
+        t.kind = LEX_IDENT;
+    } else if (isdigit((unsigned char)c) || (c == '.' && p + 1 < end && isdigit((unsigned char)p[1]))) {
+        while (p < end && isdigit((unsigned char)*p)) p++;
+        if (p < end && *p == '.') {
+            p++;
+            while (p < end && isdigit((unsigned char)*p)) p++;
+        }
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            const char *q = p + 1;
+            if (q < end && (*q == '+' || *q == '-')) q++;
+            if (q < end && isdigit((unsigned char)*q)) {
+                p = q;
+                while (p < end && isdigit((unsigned char)*p)) p++;
+            }
+        }
+        t.kind = LEX_NUMBER;
+    } else if (c == '"') {
+        p++;
+        while (p < end && *p != '"') {
+            if (*p == '\\' && p + 1 < end) p++;
+            p++;
+        }
+        if (p < end) p++; // closing quote
+        t.kind = LEX_STRING;
+    } else {
+        p++;
+        t.kind = LEX_OP;
+        switch (c) {
+        case '(': t.kind = LEX_LPAREN; break;
+        case ')': t.kind = LEX_RPAREN; break;
+        case ',': t.kind = LEX_COMMA; break;
+        case '{': t.kind = LEX_LBRACE; break;
+        case '}': t.kind = LEX_RBRACE; break;
+        case '=': case '!': case '<': case '>':
+            if (p < end && *p == '=') p++;
+            break;
+        case '&': case '|':
+            if (p < end && *p == c) p++;
+            else t.kind = LEX_OTHER;
+            break;
+        case '+': case '-': case '*': case '/': case '%': case '^':
+            break;
+        default:
+            t.kind = LEX_OTHER;
+        }
+    }
+    t.start = s;
+    t.len = (size_t)(p - s);
+    lx->pos = p;
+    return t;
+}
+
+int nvx_lex_is(const NVXLexToken *t, const char *word) {
+    return strlen(word) == t->len && memcmp(t->start, word, t->len) == 0;
+}
+
+NVXSpan nvx_span_trim(NVXSpan s) {
+    while (s.len && isspace((unsigned char)s.start[0])) { s.start++; s.len--; }
+    while (s.len && isspace((unsigned char)s.start[s.len-1])) s.len--;
+    return s;
+}
+
+NVXSpan nvx_span_unquote(NVXSpan s) {
+    if (s.len >= 2 && s.start[0] == '"' && s.start[s.len-1] == '"') {
+        s.start++;
+        s.len -= 2;
+    }
+    return s;
+}
+
+int nvx_span_is_identifier(NVXSpan s) {
+    if (!s.len || !is_ident_start(s.start[0])) return 0;
+    for (size_t i = 1; i < s.len; ++i) {
+        if (!is_ident_char(s.start[i])) return 0;
+    }
+    return 1;
+}
+
+int nvx_span_is_group(NVXSpan s) {
+    NVXLexer lx;
+    nvx_lex_init(&lx, s.start, s.len);
+    NVXLexToken t = nvx_lex_next(&lx);
+    if (t.kind != LEX_LPAREN) return 0;
+    int depth = 1;
+    while ((t = nvx_lex_next(&lx)).kind != LEX_END) {
+        if (t.kind == LEX_LPAREN) depth++;
+        else if (t.kind == LEX_RPAREN && --depth == 0) return t.start + 1 == s.start + s.len;
+    }
+    return 0;
+}
+
+char *nvx_span_dup(NVXSpan s) {
+    char *copy = nvx_malloc(s.len + 1);
+    if (!copy) return NULL;
+    memcpy(copy, s.start, s.len);
+    copy[s.len] = '\0';
+    return copy;
+}
+
+int nvx_lex_call_args(const char *text, size_t len, NVXSpan *out) {
+    NVXLexer lx;
+    nvx_lex_init(&lx, text, len);
+    NVXLexToken t;
+    do { t = nvx_lex_next(&lx); } while (t.kind != LEX_END && t.kind != LEX_LPAREN);
+    if (t.kind == LEX_END) return 0;
+    const char *from = t.start + 1;
+    const char *to = text + len;
+    int depth = 1;
+    while ((t = nvx_lex_next(&lx)).kind != LEX_END) {
+        if (t.kind == LEX_LPAREN) depth++;
+        else if (t.kind == LEX_RPAREN && --depth == 0) { to = t.start; break; }
+    }
+    NVXSpan s = { from, (size_t)(to - from) };
+    *out = nvx_span_trim(s);
+    return 1;
+}
+
+int nvx_lex_split_args(const char *text, size_t len, NVXSpan *out, int max) {
+    NVXLexer lx;
+    nvx_lex_init(&lx, text, len);
+    NVXLexToken t;
+    const char *from = text;
+    int n = 0, depth = 0;
+    while (n < max - 1 && (t = nvx_lex_next(&lx)).kind != LEX_END) {
+        if (t.kind == LEX_LPAREN) depth++;
+        else if (t.kind == LEX_RPAREN) depth--;
+        else if (t.kind == LEX_COMMA && depth <= 0) {
+            NVXSpan arg = { from, (size_t)(t.start - from) };
+            out[n++] = nvx_span_trim(arg);
+            from = t.start + 1;
+        }
+    }
+    NVXSpan last = { from, (size_t)(text + len - from) };
+    last = nvx_span_trim(last);
+    if (n == 0 && last.len == 0) return 0;
+    out[n] = last;
+    return n + 1;
+}
@@ -0,0 +1,58 @@
+#ifndef NVX_LEX_H
+#define NVX_LEX_H
+
+#include <stddef.h>
+
+// shared lexer: tokens are pointer+length spans into the caller's text,
+// nothing is copied or modified. Used by the script compiler, the math
+// tokenizer and the statement handlers.
+
+typedef enum {
+    LEX_END,
+    LEX_IDENT,   // letters, digits, '_' and inner '.' (print, nvx.http_get)
+    LEX_NUMBER,  // 12, 3.5, .5, 1e-3 (no sign)
+    LEX_STRING,  // "..." including the quotes; \" does not end it
+    LEX_OP,      // == != <= >= && || or one of + - * / % ^ = < > !
+    LEX_LPAREN, LEX_RPAREN, LEX_COMMA, LEX_LBRACE, LEX_RBRACE,
+    LEX_OTHER    // any other single character
+} NVXLexKind;
+
+typedef struct { const char *start; size_t len; } NVXSpan;
+
+typedef struct {
+    NVXLexKind kind;
+    const char *start;
+    size_t len;
+} NVXLexToken;
+
+typedef struct { const char *pos, *end; } NVXLexer;
+
+void nvx_lex_init(NVXLexer *lx, const char *text, size_t len);
+
+// next token; LEX_END (len 0) at the end of the text
+NVXLexToken nvx_lex_next(NVXLexer *lx);
+
+// 1 if the token text is exactly word
+int nvx_lex_is(const NVXLexToken *t, const char *word);
+
+// span helpers
+NVXSpan nvx_span_trim(NVXSpan s);
+// the contents of a single "..." token, otherwise s unchanged
+NVXSpan nvx_span_unquote(NVXSpan s);
+// 1 if s is exactly one identifier without dots
+int nvx_span_is_identifier(NVXSpan s);
+// 1 if s is one parenthesised group: `(` with its matching `)` at the end
+int nvx_span_is_group(NVXSpan s);
+// malloc'd NUL-terminated copy of s (NULL on allocation failure)
+char *nvx_span_dup(NVXSpan s);
+
+// text between the first '(' and its matching ')' (or the end), trimmed;
+// returns 0 if there is no '('
+int nvx_lex_call_args(const char *text, size_t len, NVXSpan *out);
+
+// split at commas outside strings and parentheses into at most max trimmed
+// spans, the last one holding the rest of the text; returns the number of
+// spans (0 for blank text)
+int nvx_lex_split_args(const char *text, size_t len, NVXSpan *out, int max);
+
+#endif // NVX_LEX_H
@@ -1,21 +1,85 @@
 #include "NVXMath.h"
+#include "NVXVars.h"
+#include "NVXContext.h"
+#include "NVXLex.h"
+#include "NVXArena.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <ctype.h>
+// x86 builds with GCC or Clang carry AVX2 kernels next to the baseline ones
+// and pick them at run time, so the default build uses AVX2 where it exists
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NVX_VEC_AVX2 1
+#endif
+#if defined(NVX_VEC_AVX2) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 // Expression evaluator using shunting-yard -> RPN evaluation
 
-typedef enum {T_NUMBER, T_VAR, T_OP, T_LP, T_RP, T_FUNC} ExprTokenType;
-typedef struct { ExprTokenType type; double value; char op; char name[64]; } Token;
+typedef double (*MathFunc1)(double);
+typedef double (*MathFunc2)(double, double);
 
-static int is_known_func(const char *name) {
-    static const char *funcs[] = {"sin", "cos", "tan", "asin", "acos", "atan", "atan2", "sqrt", "hypot", "abs", "floor", "ceil", "round", "log", "log2", "ln", "exp", "sinh", "cosh", "tanh", "asinh", "acosh", "atanh", "min", "max", NULL};
-    for (int i = 0; funcs[i]; i++) if (strcmp(name, funcs[i]) == 0) return 1;
-    return 0;
+static double fn_min(double a, double b) { return (a < b) ? a : b; }
+static double fn_max(double a, double b) { return (a > b) ? a : b; }
+
+// Built-in functions, sorted by name for binary search. arity is 1 or 2;
+// FUNC_VARIADIC takes two or more arguments and folds them pairwise with f2.
+#define FUNC_VARIADIC -2
+typedef struct { const char *name; int arity; MathFunc1 f1; MathFunc2 f2; } MathFuncDef;
+static const MathFuncDef math_funcs[] = {
+    {"abs",   1, fabs,  NULL},
+    {"acos",  1, acos,  NULL},
+    {"acosh", 1, acosh, NULL},
+    {"asin",  1, asin,  NULL},
+    {"asinh", 1, asinh, NULL},
+    {"atan",  1, atan,  NULL},
+    {"atan2", 2, NULL,  atan2},
+    {"atanh", 1, atanh, NULL},
+    {"ceil",  1, ceil,  NULL},
+    {"cos",   1, cos,   NULL},
+    {"cosh",  1, cosh,  NULL},
+    {"exp",   1, exp,   NULL},
+    {"floor", 1, floor, NULL},
+    {"hypot", 2, NULL,  hypot},
+    {"ln",    1, log,   NULL},
+    {"log",   1, log10, NULL},
+    {"log2",  1, log2,  NULL},
+    {"max",   FUNC_VARIADIC, NULL, fn_max},
+    {"min",   FUNC_VARIADIC, NULL, fn_min},
+    {"mod",   2, NULL,  fmod},
+    {"round", 1, round, NULL},
+    {"sin",   1, sin,   NULL},
+    {"sinh",  1, sinh,  NULL},
+    {"sqrt",  1, sqrt,  NULL},
+    {"tan",   1, tan,   NULL},
+    {"tanh",  1, tanh,  NULL},
+};
+#define MATH_FUNC_COUNT ((int)(sizeof(math_funcs) / sizeof(math_funcs[0])))
+
+// index into math_funcs, or -1
+static int find_func(const char *name, size_t len) {
+    int lo = 0, hi = MATH_FUNC_COUNT - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int c = strncmp(name, math_funcs[mid].name, len);
+        if (c == 0) c = (math_funcs[mid].name[len] == '\0') ? 0 : -1;
+        if (c == 0) return mid;
+        if (c < 0) hi = mid - 1;
+        else lo = mid + 1;
+    }
+    return -1;
 }
 
+typedef enum {T_NUMBER, T_VAR, T_OP, T_LP, T_RP, T_FUNC, T_COMMA} ExprTokenType;
+// func is the math_funcs index of a T_FUNC token, argc its argument count
+// (filled in by shunting_yard); name points into the expression text
+typedef struct { ExprTokenType type; double value; char op; int func; int argc; const char *name; size_t name_len; } Token;
+
+#define EXPR_MAX_TOKENS 256
+
 static int precedence(char op) {
     switch (op) {
         case 'u': return 5; // unary minus
@@ -30,61 +94,60 @@ static int is_right_assoc(char op) {
     return (op == '^' || op == 'u');
 }
 
+// unary position: start of expression, after an operator, '(' or ','
+static int unary_position(int idx, ExprTokenType prev) {
+    return idx == 0 || prev == T_OP || prev == T_LP || prev == T_COMMA;
+}
+
 static int tokenize(const char *s, Token *out, int *out_len) {
-    int pos = 0;
+    NVXLexer lx;
+    nvx_lex_init(&lx, s, strlen(s));
     int idx = 0;
-    Token prev = {0};
-    while (s[pos]) {
-        if (isspace((unsigned char)s[pos])) { pos++; continue; }
-        if ((s[pos] >= '0' && s[pos] <= '9') || (s[pos]=='.' && isdigit((unsigned char)s[pos+1])) || ((s[pos]=='-' ) && ((pos==0) || (prev.type==T_OP) || (prev.type==T_LP)) && (isdigit((unsigned char)s[pos+1]) || s[pos+1]=='.'))) {
-            char *endptr;
-            double v = strtod(s + pos, &endptr);
-            out[idx].type = T_NUMBER;
-            out[idx].value = v;
-            pos += (endptr - (s + pos));
-            prev = out[idx]; idx++;
-            continue;
-        }
-        if (isalpha((unsigned char)s[pos]) || s[pos]=='_') {
-            int j = 0;
-            while (s[pos] && (isalnum((unsigned char)s[pos]) || s[pos]=='_')) {
-                if (j < (int)sizeof(out[idx].name)-1) out[idx].name[j++] = s[pos];
-                pos++;
-            }
-            out[idx].name[j] = '\0';
-            int check_pos = pos;
-            while (s[check_pos] && isspace((unsigned char)s[check_pos])) check_pos++;
-            if (s[check_pos] == '(' && is_known_func(out[idx].name)) {
-                out[idx].type = T_FUNC;
-            } else {
-                out[idx].type = T_VAR;
-            }
-            prev = out[idx]; idx++;
-            continue;
-        }
-        if (s[pos] == '(') { out[idx].type = T_LP; out[idx].op = '('; prev = out[idx]; idx++; pos++; continue; }
-        if (s[pos] == ')') { out[idx].type = T_RP; out[idx].op = ')'; prev = out[idx]; idx++; pos++; continue; }
-        char c = s[pos];
-        if (c=='+'||c=='-'||c=='*'||c=='/'||c=='%'||c=='^') {
-            out[idx].type = T_OP; out[idx].op = c; prev = out[idx]; idx++; pos++; continue;
-        }
-        return 0;
+    ExprTokenType prev = T_OP;
+    NVXLexToken lt = nvx_lex_next(&lx);
+    while (lt.kind != LEX_END) {
+        if (idx >= EXPR_MAX_TOKENS) return 0;
+        Token *t = &out[idx];
+        NVXLexToken next = nvx_lex_next(&lx);
+        if (lt.kind == LEX_NUMBER || (lt.kind == LEX_OP && lt.start[0] == '-' && unary_position(idx, prev) && next.kind == LEX_NUMBER && next.start == lt.start + 1)) {
+            // a '-' directly in front of a number in unary position is part of the literal
+            if (lt.kind == LEX_OP) next = nvx_lex_next(&lx);
+            t->type = T_NUMBER;
+            t->value = strtod(lt.start, NULL);
+        } else if (lt.kind == LEX_IDENT) {
+            if (memchr(lt.start, '.', lt.len)) return 0;
+            t->name = lt.start;
+            t->name_len = lt.len;
+            t->func = (next.kind == LEX_LPAREN) ? find_func(lt.start, lt.len) : -1;
+            t->type = (t->func >= 0) ? T_FUNC : T_VAR;
+        } else if (lt.kind == LEX_LPAREN) { t->type = T_LP; t->op = '('; }
+        else if (lt.kind == LEX_RPAREN) { t->type = T_RP; t->op = ')'; }
+        else if (lt.kind == LEX_COMMA) { t->type = T_COMMA; t->op = ','; }
+        else if (lt.kind == LEX_OP && lt.len == 1 && strchr("+-*/%^", lt.start[0])) { t->type = T_OP; t->op = lt.start[0]; }
+        else return 0;
+        prev = t->type; idx++;
+        lt = next;
     }
     *out_len = idx;
     return 1;
 }
 
 static int shunting_yard(Token *tokens, int ntok, Token *out, int *out_len) {
-    Token ops[256]; int ops_top = 0;
+    Token ops[EXPR_MAX_TOKENS]; int ops_top = 0;
+    int argc[EXPR_MAX_TOKENS]; // per open parenthesis on ops: arguments seen so far
     int out_i = 0;
     for (int i = 0; i < ntok; ++i) {
         Token t = tokens[i];
         if (t.type == T_NUMBER || t.type == T_VAR) { out[out_i++] = t; continue; }
-        if (t.type == T_FUNC) { ops[ops_top++] = t; continue; }
+        if (t.type == T_FUNC) {
+            if (i + 1 >= ntok || tokens[i+1].type != T_LP) return 0;
+            ops[ops_top++] = t;
+            continue;
+        }
         if (t.type == T_OP) {
             char op = t.op;
             if (op == '-') {
-                if (i==0 || tokens[i-1].type==T_OP || tokens[i-1].type==T_LP) op = 'u';
+                if (i==0 || tokens[i-1].type==T_OP || tokens[i-1].type==T_LP || tokens[i-1].type==T_COMMA) op = 'u';
             }
             while (ops_top > 0 && ops[ops_top-1].type == T_OP) {
                 char topop = ops[ops_top-1].op;
@@ -96,128 +159,371 @@ static int shunting_yard(Token *tokens, int ntok, Token *out, int *out_len) {
                 }
                 break;
             }
-            Token push = {T_OP, 0, op, {0}}; ops[ops_top++] = push;
+            t.op = op;
+            ops[ops_top++] = t;
+            continue;
+        }
+        if (t.type == T_LP) {
+            argc[ops_top] = (i + 1 < ntok && tokens[i+1].type == T_RP) ? 0 : 1;
+            ops[ops_top++] = t;
+            continue;
+        }
+        if (t.type == T_COMMA) {
+            while (ops_top > 0 && ops[ops_top-1].type != T_LP) out[out_i++] = ops[--ops_top];
+            // commas are only valid directly inside a function call's parentheses
+            if (ops_top < 2 || ops[ops_top-2].type != T_FUNC) return 0;
+            argc[ops_top-1]++;
             continue;
         }
-        if (t.type == T_LP) { ops[ops_top++] = t; continue; }
         if (t.type == T_RP) {
-            int found = 0;
-            while (ops_top > 0) {
-                Token top = ops[--ops_top];
-                if (top.type == T_LP) { found = 1; break; }
-                if (top.type == T_FUNC) { out[out_i++] = top; break; }
-                out[out_i++] = top;
+            while (ops_top > 0 && ops[ops_top-1].type != T_LP) out[out_i++] = ops[--ops_top];
+            if (ops_top == 0) return 0;
+            int n = argc[--ops_top];
+            if (ops_top > 0 && ops[ops_top-1].type == T_FUNC) {
+                Token f = ops[--ops_top];
+                f.argc = n;
+                out[out_i++] = f;
             }
-            if (!found) return 0;
             continue;
         }
     }
     while (ops_top > 0) {
         Token top = ops[--ops_top];
-        if (top.type == T_LP || top.type == T_RP) return 0;
+        if (top.type != T_OP) return 0;
         out[out_i++] = top;
     }
     *out_len = out_i;
     return 1;
 }
 
-static double apply_func(const char *fname, double arg) {
-    if (strcmp(fname, "sin") == 0) return sin(arg);
-    if (strcmp(fname, "cos") == 0) return cos(arg);
-    if (strcmp(fname, "tan") == 0) return tan(arg);
-    if (strcmp(fname, "asin") == 0) return asin(arg);
-    if (strcmp(fname, "acos") == 0) return acos(arg);
-    if (strcmp(fname, "atan") == 0) return atan(arg);
-    if (strcmp(fname, "sinh") == 0) return sinh(arg);
-    if (strcmp(fname, "cosh") == 0) return cosh(arg);
-    if (strcmp(fname, "tanh") == 0) return tanh(arg);
-    if (strcmp(fname, "asinh") == 0) return asinh(arg);
-    if (strcmp(fname, "acosh") == 0) return acosh(arg);
-    if (strcmp(fname, "atanh") == 0) return atanh(arg);
-    if (strcmp(fname, "sqrt") == 0) return sqrt(arg);
-    if (strcmp(fname, "abs") == 0) return fabs(arg);
-    if (strcmp(fname, "floor") == 0) return floor(arg);
-    if (strcmp(fname, "ceil") == 0) return ceil(arg);
-    if (strcmp(fname, "round") == 0) return round(arg);
-    if (strcmp(fname, "log") == 0) return log10(arg);
-    if (strcmp(fname, "log2") == 0) return log2(arg);
-    if (strcmp(fname, "ln") == 0) return log(arg);
-    if (strcmp(fname, "exp") == 0) return exp(arg);
-    return 0; // unknown function
-}
-
-static double apply_func2(const char *fname, double a, double b) {
-    if (strcmp(fname, "min") == 0) return (a < b) ? a : b;
-    if (strcmp(fname, "max") == 0) return (a > b) ? a : b;
-    if (strcmp(fname, "atan2") == 0) return atan2(a, b);
-    if (strcmp(fname, "hypot") == 0) return hypot(a, b);
-    if (strcmp(fname, "mod") == 0) return fmod(a, b);
-    return 0;
-}
+// Compiled form: RPN with variables bound to store slots and functions to pointers
+enum { E_NUM, E_VAR, E_NEG, E_ADD, E_SUB, E_MUL, E_DIV, E_MOD, E_POW, E_CALL1, E_CALL2 };
+typedef struct {
+    unsigned char code;
+    int slot;
+    union { double num; MathFunc1 f1; MathFunc2 f2; } u;
+} ExprOp;
 
-extern const char* get_variable(const char *name); // forward from vars
+struct NVXExpr {
+    int len;
+    int depth; // maximum evaluation stack depth
+    ExprOp ops[];
+};
 
-static int evaluate_rpn(Token *rpn, int len, double *out_val) {
-    double stack[256]; int top = 0;
-    for (int i = 0; i < len; ++i) {
-        Token t = rpn[i];
-        if (t.type == T_NUMBER) { stack[top++] = t.value; continue; }
-        if (t.type == T_VAR) {
-            const char *v = get_variable(t.name);
-            if (!v) return 0;
-            stack[top++] = atof(v);
-            continue;
-        }
-        if (t.type == T_FUNC) {
-            if (strcmp(t.name, "min") == 0 || strcmp(t.name, "max") == 0) {
-                if (top < 2) return 0;
-                double b = stack[--top];
-                double a = stack[--top];
-                double res = apply_func2(t.name, a, b);
-                stack[top++] = res;
+#define EXPR_MAX_STACK 256
+
+NVXExpr *nvx_expr_compile(NVXContext *ctx, const char *expr) {
+    Token toks[EXPR_MAX_TOKENS]; int ntok = 0;
+    if (!tokenize(expr, toks, &ntok)) return NULL;
+    Token rpn[EXPR_MAX_TOKENS]; int rlen = 0;
+    if (!shunting_yard(toks, ntok, rpn, &rlen)) return NULL;
+    // variadic calls expand to one binary op per extra argument
+    int nops = 0;
+    for (int i = 0; i < rlen; ++i) {
+        if (rpn[i].type == T_FUNC && math_funcs[rpn[i].func].arity == FUNC_VARIADIC) nops += rpn[i].argc > 1 ? rpn[i].argc - 1 : 1;
+        else nops++;
+    }
+    NVXExpr *e = nvx_malloc(sizeof(NVXExpr) + (size_t)nops * sizeof(ExprOp));
+    if (!e) return NULL;
+    e->len = 0;
+    e->depth = 0;
+    int depth = 0; // simulated stack depth, rejects malformed RPN up front
+    for (int i = 0; i < rlen; ++i) {
+        const Token *t = &rpn[i];
+        ExprOp *op = &e->ops[e->len++];
+        op->slot = -1;
+        if (t->type == T_NUMBER) {
+            op->code = E_NUM; op->u.num = t->value; depth++;
+        } else if (t->type == T_VAR) {
+            op->code = E_VAR; op->slot = nvx_var_slot_n(ctx, t->name, t->name_len); depth++;
+            if (op->slot < 0) { free(e); return NULL; }
+        } else if (t->type == T_FUNC) {
+            const MathFuncDef *f = &math_funcs[t->func];
+            if (f->arity == FUNC_VARIADIC) {
+                if (t->argc < 2) { free(e); return NULL; }
+                op->code = E_CALL2; op->u.f2 = f->f2;
+                for (int k = 2; k < t->argc; ++k) e->ops[e->len++] = *op;
+            } else if (t->argc != f->arity) {
+                free(e); return NULL;
+            } else if (f->arity == 2) {
+                op->code = E_CALL2; op->u.f2 = f->f2;
             } else {
-                if (top < 1) return 0;
-                double a = stack[--top];
-                double res = apply_func(t.name, a);
-                stack[top++] = res;
-            }
-            continue;
-        }
-        if (t.type == T_OP) {
-            char op = t.op;
-            if (op == 'u') {
-                if (top < 1) return 0;
-                double a = stack[--top];
-                stack[top++] = -a;
-                continue;
+                op->code = E_CALL1; op->u.f1 = f->f1;
             }
-            if (top < 2) return 0;
-            double b = stack[--top];
-            double a = stack[--top];
-            double res = 0;
-            switch (op) {
-                case '+': res = a + b; break;
-                case '-': res = a - b; break;
-                case '*': res = a * b; break;
-                case '/': if (b == 0) { printf("NVD Error: Division by zero.\n"); return 0; } res = a / b; break;
-                case '%': res = fmod(a, b); break;
-                case '^': res = pow(a, b); break;
-                default: return 0;
+            depth -= t->argc - 1;
+            if (t->argc < 1 || depth < 1) { free(e); return NULL; }
+        } else if (t->type == T_OP) {
+            switch (t->op) {
+                case 'u': op->code = E_NEG; break;
+                case '+': op->code = E_ADD; break;
+                case '-': op->code = E_SUB; break;
+                case '*': op->code = E_MUL; break;
+                case '/': op->code = E_DIV; break;
+                case '%': op->code = E_MOD; break;
+                case '^': op->code = E_POW; break;
+                default: free(e); return NULL;
             }
-            stack[top++] = res;
-            continue;
+            if (op->code != E_NEG) depth--;
+            if (depth < 1) { free(e); return NULL; }
+        } else {
+            free(e); return NULL;
+        }
+        if (depth > EXPR_MAX_STACK) { free(e); return NULL; }
+        if (depth > e->depth) e->depth = depth;
+    }
+    if (depth != 1) { free(e); return NULL; }
+    return e;
+}
+
+void nvx_expr_free(NVXExpr *e) {
+    free(e);
+}
+
+int nvx_expr_eval(NVXContext *ctx, const NVXExpr *e, double *out_val) {
+    double stack[EXPR_MAX_STACK]; int top = 0;
+    for (int i = 0; i < e->len; ++i) {
+        const ExprOp *op = &e->ops[i];
+        switch (op->code) {
+            case E_NUM: stack[top++] = op->u.num; break;
+            case E_VAR: if (!nvx_var_number(ctx, op->slot, &stack[top])) return 0; top++; break;
+            case E_NEG: stack[top-1] = -stack[top-1]; break;
+            case E_CALL1: stack[top-1] = op->u.f1(stack[top-1]); break;
+            case E_CALL2: top--; stack[top-1] = op->u.f2(stack[top-1], stack[top]); break;
+            case E_ADD: top--; stack[top-1] += stack[top]; break;
+            case E_SUB: top--; stack[top-1] -= stack[top]; break;
+            case E_MUL: top--; stack[top-1] *= stack[top]; break;
+            case E_DIV:
+                top--;
+                if (stack[top] == 0) { printf("NVD Error: Division by zero.\n"); return 0; }
+                stack[top-1] /= stack[top];
+                break;
+            case E_MOD: top--; stack[top-1] = fmod(stack[top-1], stack[top]); break;
+            case E_POW: top--; stack[top-1] = pow(stack[top-1], stack[top]); break;
         }
     }
-    if (top != 1) return 0;
     *out_val = stack[0];
     return 1;
 }
 
+// Batch evaluation: the RPN program runs over blocks of rows, so each op is a
+// tight loop over BATCH_BLOCK values. Arithmetic uses AVX2 when the CPU has it
+// (checked at run time), SSE2 when the build targets it and a scalar loop
+// otherwise; functions call libm per value.
+#define BATCH_BLOCK 256
+
+static void vec_add(double *a, const double *b, size_t n) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(a + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+#endif
+    for (; i < n; ++i) a[i] += b[i];
+}
+
+static void vec_sub(double *a, const double *b, size_t n) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(a + i, _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+#endif
+    for (; i < n; ++i) a[i] -= b[i];
+}
+
+static void vec_mul(double *a, const double *b, size_t n) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(a + i, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+#endif
+    for (; i < n; ++i) a[i] *= b[i];
+}
+
+static void vec_div(double *a, const double *b, size_t n) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(a + i, _mm_div_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+#endif
+    for (; i < n; ++i) a[i] /= b[i];
+}
+
+static void vec_neg(double *a, size_t n) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128d sign = _mm_set1_pd(-0.0);
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(a + i, _mm_xor_pd(_mm_loadu_pd(a + i), sign));
+#endif
+    for (; i < n; ++i) a[i] = -a[i];
+}
+
+typedef struct {
+    void (*add)(double *, const double *, size_t);
+    void (*sub)(double *, const double *, size_t);
+    void (*mul)(double *, const double *, size_t);
+    void (*div)(double *, const double *, size_t);
+    void (*neg)(double *, size_t);
+} VecOps;
+
+static const VecOps vec_base = { vec_add, vec_sub, vec_mul, vec_div, vec_neg };
+
+#ifdef NVX_VEC_AVX2
+__attribute__((target("avx2"))) static void vec_add_avx2(double *a, const double *b, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(a + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    for (; i < n; ++i) a[i] += b[i];
+}
+
+__attribute__((target("avx2"))) static void vec_sub_avx2(double *a, const double *b, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(a + i, _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    for (; i < n; ++i) a[i] -= b[i];
+}
+
+__attribute__((target("avx2"))) static void vec_mul_avx2(double *a, const double *b, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(a + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    for (; i < n; ++i) a[i] *= b[i];
+}
+
+__attribute__((target("avx2"))) static void vec_div_avx2(double *a, const double *b, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(a + i, _mm256_div_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    for (; i < n; ++i) a[i] /= b[i];
+}
+
+__attribute__((target("avx2"))) static void vec_neg_avx2(double *a, size_t n) {
+    size_t i = 0;
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(a + i, _mm256_xor_pd(_mm256_loadu_pd(a + i), sign));
+    for (; i < n; ++i) a[i] = -a[i];
+}
+
+static const VecOps vec_avx2 = { vec_add_avx2, vec_sub_avx2, vec_mul_avx2, vec_div_avx2, vec_neg_avx2 };
+#endif
+
+// kernels for the CPU this runs on; the check reads a flag set at startup
+static const VecOps *vec_ops(void) {
+#ifdef NVX_VEC_AVX2
+    if (__builtin_cpu_supports("avx2")) return &vec_avx2;
+#endif
+    return &vec_base;
+}
+
+static void vec_fill(double *a, double v, size_t n) {
+    for (size_t i = 0; i < n; ++i) a[i] = v;
+}
+
+int nvx_expr_eval_batch(NVXContext *ctx, const NVXExpr *e, const char **names, const double **columns, int ncols, size_t n, double *out) {
+    // bind each variable op to its input column, or to its current scalar value
+    const double **col_of = nvx_malloc((size_t)e->len * sizeof(double *) + 1);
+    double *scalar = nvx_malloc((size_t)e->len * sizeof(double) + 1);
+    double *stack = nvx_malloc((size_t)(e->depth ? e->depth : 1) * BATCH_BLOCK * sizeof(double));
+    const VecOps *v = vec_ops();
+    int ok = (col_of && scalar && stack);
+    for (int i = 0; ok && i < e->len; ++i) {
+        col_of[i] = NULL;
+        if (e->ops[i].code != E_VAR) continue;
+        for (int c = 0; c < ncols; ++c) {
+            if (nvx_find_var_slot(ctx, names[c]) == e->ops[i].slot) { col_of[i] = columns[c]; break; }
+        }
+        if (!col_of[i] && !nvx_var_number(ctx, e->ops[i].slot, &scalar[i])) {
+            printf("NVD Error: No input column or value for '%s'.\n", ctx->vars[e->ops[i].slot].name);
+            ok = 0;
+        }
+    }
+    for (size_t base = 0; ok && base < n; base += BATCH_BLOCK) {
+        size_t m = (n - base < BATCH_BLOCK) ? n - base : BATCH_BLOCK;
+        int top = 0;
+        for (int i = 0; i < e->len; ++i) {
+            const ExprOp *op = &e->ops[i];
+            double *sp = stack + (size_t)top * BATCH_BLOCK; // next free slot
+            double *y = top >= 1 ? sp - BATCH_BLOCK : sp;     // top of stack
+            double *x = top >= 2 ? sp - 2 * BATCH_BLOCK : sp; // left operand of binary ops
+            switch (op->code) {
+                case E_NUM: vec_fill(sp, op->u.num, m); top++; break;
+                case E_VAR:
+                    if (col_of[i]) memcpy(sp, col_of[i] + base, m * sizeof(double));
+                    else vec_fill(sp, scalar[i], m);
+                    top++;
+                    break;
+                case E_NEG: v->neg(y, m); break;
+                case E_CALL1: for (size_t k = 0; k < m; ++k) y[k] = op->u.f1(y[k]); break;
+                case E_CALL2: for (size_t k = 0; k < m; ++k) x[k] = op->u.f2(x[k], y[k]); top--; break;
+                case E_ADD: v->add(x, y, m); top--; break;
+                case E_SUB: v->sub(x, y, m); top--; break;
+                case E_MUL: v->mul(x, y, m); top--; break;
+                case E_DIV:
+                    for (size_t k = 0; k < m; ++k) {
+                        if (y[k] == 0) { printf("NVD Error: Division by zero (row %zu).\n", base + k + 1); ok = 0; break; }
+                    }
+                    if (ok) v->div(x, y, m);
+                    top--;
+                    break;
+                case E_MOD: for (size_t k = 0; k < m; ++k) x[k] = fmod(x[k], y[k]); top--; break;
+                case E_POW: for (size_t k = 0; k < m; ++k) x[k] = pow(x[k], y[k]); top--; break;
+            }
+            if (!ok) break;
+        }
+        if (ok) memcpy(out + base, stack, m * sizeof(double));
+    }
+    free(col_of);
+    free(scalar);
+    free(stack);
+    return ok;
+}
+
+// Expression cache, one per context: open-addressing table keyed by the
+// expression text, allocated on first use. Parse failures are cached too
+// (expr == NULL). When the table fills up it is flushed, which keeps memory
+// bounded for scripts that build expressions at runtime.
+#define EXPR_CACHE_SIZE 1024
+typedef struct NVXExprCacheEntry { char *key; size_t hash; NVXExpr *expr; } ExprCacheEntry;
+
+static void expr_cache_flush(NVXContext *ctx) {
+    for (int i = 0; i < EXPR_CACHE_SIZE; ++i) {
+        ExprCacheEntry *ce = &ctx->exprs[i];
+        if (!ce->key) continue;
+        free(ce->key);
+        nvx_expr_free(ce->expr);
+        ce->key = NULL;
+        ce->expr = NULL;
+    }
+    ctx->exprs_used = 0;
+}
+
+void nvx_expr_cache_destroy(NVXContext *ctx) {
+    if (!ctx->exprs) return;
+    expr_cache_flush(ctx);
+    free(ctx->exprs);
+    ctx->exprs = NULL;
+}
+
+const NVXExpr *nvx_expr_cached(NVXContext *ctx, const char *expr) {
+    if (!ctx->exprs && !(ctx->exprs = nvx_calloc(EXPR_CACHE_SIZE, sizeof(ExprCacheEntry)))) return NULL;
+    ExprCacheEntry *cache = ctx->exprs;
+    size_t h = 2166136261u; // FNV-1a
+    for (const unsigned char *p = (const unsigned char *)expr; *p; ++p) { h ^= *p; h *= 16777619u; }
+    size_t i = h & (EXPR_CACHE_SIZE - 1);
+    while (cache[i].key) {
+        if (cache[i].hash == h && strcmp(cache[i].key, expr) == 0) return cache[i].expr;
+        i = (i + 1) & (EXPR_CACHE_SIZE - 1);
+    }
+    NVXExpr *compiled = nvx_expr_compile(ctx, expr);
+    if (ctx->exprs_used >= EXPR_CACHE_SIZE / 2) {
+        expr_cache_flush(ctx);
+        i = h & (EXPR_CACHE_SIZE - 1);
+    }
+    char *key = nvx_strdup(expr);
+    if (!key) { nvx_expr_free(compiled); return NULL; }
+    cache[i].key = key;
+    cache[i].hash = h;
+    cache[i].expr = compiled;
+    ctx->exprs_used++;
+    return compiled;
+}
+
+int nvx_evaluate_math(NVXContext *ctx, const char *expr, double *result) {
+    const NVXExpr *e = nvx_expr_cached(ctx, expr);
+    if (!e) return 0;
+    return nvx_expr_eval(ctx, e, result);
+}
+
 int evaluate_math_expr(const char *expr, double *result) {
-    Token toks[256]; int ntok = 0;
-    if (!tokenize(expr, toks, &ntok)) return 0;
-    Token rpn[256]; int rlen = 0;
-    if (!shunting_yard(toks, ntok, rpn, &rlen)) return 0;
-    if (!evaluate_rpn(rpn, rlen, result)) return 0;
-    return 1;
+    return nvx_evaluate_math(nvx_default_context(), expr, result);
 }
@@ -3,7 +3,32 @@
 
 #include <stddef.h>
 
-// evaluate a math expression string, return 1 on success and result in *result
+typedef struct NVXContext NVXContext;
+
+// evaluate a math expression string against ctx's variables, return 1 on
+// success and result in *result (repeated calls with the same string reuse its
+// compiled form). evaluate_math_expr uses the default context.
+int nvx_evaluate_math(NVXContext *ctx, const char *expr, double *result);
 int evaluate_math_expr(const char *expr, double *result);
 
+// compiled expression: RPN with variable slots and functions already resolved
+typedef struct NVXExpr NVXExpr;
+
+// compile an expression, binding its variables to slots of ctx; NULL if it
+// does not parse. Free with nvx_expr_free.
+NVXExpr *nvx_expr_compile(NVXContext *ctx, const char *expr);
+void nvx_expr_free(NVXExpr *e);
+
+// evaluate against the current variable values, return 1 on success
+int nvx_expr_eval(NVXContext *ctx, const NVXExpr *e, double *result);
+
+// compile-once lookup keyed by the expression text. ctx's cache owns the
+// result (NULL if the text does not parse); it stays valid until the next call.
+const NVXExpr *nvx_expr_cached(NVXContext *ctx, const char *expr);
+
+// evaluate e over n rows. columns[i] holds the values of variable names[i];
+// variables without a column use their current value. out receives n results.
+// Returns 1 on success, 0 on error (message printed).
+int nvx_expr_eval_batch(NVXContext *ctx, const NVXExpr *e, const char **names, const double **columns, int ncols, size_t n, double *out);
+
 #endif // NVX_MATH_H
@@ -1,33 +1,121 @@
+#define _GNU_SOURCE // accept4
 #include "NVXNet.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <time.h>
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <io.h>
+#define strncasecmp _strnicmp
 #else
+#include <errno.h>
+#include <fcntl.h>
+#include <strings.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netdb.h>
 #include <unistd.h>
 #endif
+#ifdef __linux__
+#include <poll.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#endif
 
-#define MAX_ROUTES 32
-static char *route_paths[MAX_ROUTES];
-static nvx_route_handler route_handlers[MAX_ROUTES];
-static int route_count = 0;
+// what the router stores for each route: a simple or a full handler
+typedef struct {
+    nvx_route_handler handler;
+    nvx_http_handler http_handler;
+    void *data;
+    int cache_ms;                 // > 0: replies are cached this long
+} Route;
 
-void nvx_register_route(const char *path, nvx_route_handler handler) {
-    if (route_count < MAX_ROUTES) {
-        route_paths[route_count] = strdup(path);
-        route_handlers[route_count] = handler;
-        route_count++;
+static NVXRouter *router = NULL;
+static void (*worker_init)(int worker) = NULL;
+
+#define NVX_MAX_REQUEST (1 << 20) // requests larger than this are dropped
+#define NVX_RESPONSE_SIZE 4096          // buffer given to simple handlers
+#define NVX_RESPONSE_KEEP (1 << 20)     // larger reply buffers are freed after sending
+
+static int server_workers = 0; // 0 = one per online CPU, at least 4
+static int idle_timeout = 5;    // seconds an idle keep-alive connection is kept open
+static int max_keepalive = 100; // requests served on one connection before closing it
+
+static int add_route(const char *method, const char *pattern, nvx_route_handler handler,
+                     nvx_http_handler http_handler, void *data, int cache_ms) {
+    if (!router && !(router = nvx_router_new())) return -1;
+    Route *r = malloc(sizeof(Route));
+    if (!r) return -1;
+    r->handler = handler;
+    r->http_handler = http_handler;
+    r->data = data;
+    r->cache_ms = cache_ms > 0 ? cache_ms : 0;
+    if (nvx_router_add(router, method, pattern, r) < 0) {
+        free(r);
+        return -1;
     }
+    return 0;
+}
+
+void nvx_register_route(const char *path, nvx_route_handler handler) {
+    add_route(NULL, path, handler, NULL, NULL, 0);
+}
+
+int nvx_add_route(const char *method, const char *pattern, nvx_http_handler handler, void *data) {
+    return add_route(method, pattern, NULL, handler, data, 0);
+}
+
+int nvx_add_cached_route(const char *method, const char *pattern, nvx_http_handler handler,
+                         void *data, int ttl_ms) {
+    return add_route(method, pattern, NULL, handler, data, ttl_ms);
+}
+
+void nvx_set_server_workers(int workers) {
+    server_workers = workers > 0 ? workers : 0;
+}
+
+void nvx_set_worker_init(void (*init)(int worker)) {
+    worker_init = init;
+}
+
+int nvx_server_worker_count(void) {
+#ifdef __linux__
+    if (server_workers > 0) return server_workers;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 4 ? (int)cpus : 4; // handlers may block, keep a few even on small machines
+#else
+    return 1;
+#endif
+}
+
+void nvx_set_server_keepalive(int idle_seconds, int max_requests) {
+    if (idle_seconds > 0) idle_timeout = idle_seconds;
+    max_keepalive = max_requests > 0 ? max_requests : 1;
+}
+
+// sockets and the epoll fd are close-on-exec, so children started by
+// handlers (sys.spawn) do not keep clients or the port open
+#ifndef SOCK_CLOEXEC
+#define SOCK_CLOEXEC 0
+#endif
+
+static void close_socket(int s) {
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
 }
 
 static int create_listener(const char *port) {
     struct addrinfo hints, *res, *rp;
-    int s;
+    int s = -1;
     memset(&hints, 0, sizeof(hints));
     hints.ai_family = AF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
@@ -35,48 +123,746 @@ static int create_listener(const char *port) {
     int err = getaddrinfo(NULL, port, &hints, &res);
     if (err != 0) return -1;
     for (rp = res; rp != NULL; rp = rp->ai_next) {
-        s = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+        s = socket(rp->ai_family, rp->ai_socktype | SOCK_CLOEXEC, rp->ai_protocol);
         if (s == -1) continue;
         int on = 1;
         setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (char*)&on, sizeof(on));
         if (bind(s, rp->ai_addr, rp->ai_addrlen) == 0) {
-            if (listen(s, 5) == 0) break;
+            if (listen(s, SOMAXCONN) == 0) break;
         }
+        close_socket(s);
+        s = -1;
+    }
+    freeaddrinfo(res);
+    return s;
+}
+
+// Write the parts in order: one gather write unless the socket buffer fills
+// up, in which case the rest follows as room appears.
+static int send_parts(int client, const NVXHttpSpan *parts, int n) {
 #ifdef _WIN32
-        closesocket(s);
+    for (int i = 0; i < n; ++i) {
+        const char *p = parts[i].ptr;
+        size_t len = parts[i].len;
+        while (len > 0) {
+            int sent = send(client, p, (int)len, 0);
+            if (sent <= 0) return -1;
+            p += sent;
+            len -= (size_t)sent;
+        }
+    }
+    return 0;
+#else
+    struct iovec iov[8], *v = iov;
+    int cnt = 0;
+    for (int i = 0; i < n && cnt < 8; ++i) {
+        if (!parts[i].len) continue;
+        iov[cnt].iov_base = (void *)parts[i].ptr;
+        iov[cnt].iov_len = parts[i].len;
+        cnt++;
+    }
+    while (cnt > 0) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = v;
+        msg.msg_iovlen = (size_t)cnt;
+#ifdef __linux__
+        // keep-alive clients may hang up at any time: no SIGPIPE, and wait
+        // for room when the non-blocking socket buffer is full
+        ssize_t sent = sendmsg(client, &msg, MSG_NOSIGNAL);
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            struct pollfd pfd = { .fd = client, .events = POLLOUT };
+            if (poll(&pfd, 1, idle_timeout * 1000) <= 0) return -1;
+            continue;
+        }
 #else
-        close(s);
+        ssize_t sent = sendmsg(client, &msg, 0);
+        if (sent < 0 && errno == EINTR) continue;
 #endif
+        if (sent <= 0) return -1;
+        while (cnt > 0 && (size_t)sent >= v->iov_len) {
+            sent -= (ssize_t)v->iov_len;
+            v++;
+            cnt--;
+        }
+        if (cnt > 0) {
+            v->iov_base = (char *)v->iov_base + sent;
+            v->iov_len -= (size_t)sent;
+        }
     }
-    freeaddrinfo(res);
-    return s;
+    return 0;
+#endif
+}
+
+static int span_is(NVXHttpSpan s, const char *word) {
+    size_t n = strlen(word);
+    return s.len == n && strncasecmp(s.ptr, word, n) == 0;
+}
+
+// Parse the request at the start of buf in one pass over the request line
+// and headers. Returns the full length (headers plus Content-Length body),
+// 0 if more data is needed, -1 if the request is malformed or too large, and
+// -2 if its body uses Transfer-Encoding, which is not supported: its length
+// is unknown, so the rest of the stream cannot be framed.
+static long parse_request(const char *buf, size_t len, NVXHttpRequest *req) {
+    const char *p = buf, *end = buf + len;
+    const char *sp = memchr(p, ' ', len);
+    if (!sp) return len > 32 || memchr(p, '\n', len) ? -1 : 0;
+    req->method.ptr = p;
+    req->method.len = (size_t)(sp - p);
+    p = sp + 1;
+    const char *eol = memchr(p, '\n', (size_t)(end - p));
+    if (!eol) return (size_t)(end - buf) > 8192 ? -1 : 0;
+    const char *line_end = eol > p && eol[-1] == '\r' ? eol - 1 : eol;
+    sp = memchr(p, ' ', (size_t)(line_end - p));
+    if (!req->method.len || !sp || *p != '/') return -1;
+    const char *q = memchr(p, '?', (size_t)(sp - p));
+    req->path.ptr = p;
+    req->path.len = (size_t)((q ? q : sp) - p);
+    req->query.ptr = q ? q + 1 : sp;
+    req->query.len = q ? (size_t)(sp - q - 1) : 0;
+    req->version.ptr = sp + 1;
+    req->version.len = (size_t)(line_end - sp - 1);
+    // HTTP/1.1 defaults to persistent connections, HTTP/1.0 to close
+    req->keep_alive = span_is(req->version, "HTTP/1.1");
+    req->header_count = 0;
+    size_t body_len = 0;
+    int chunked = 0;
+    for (p = eol + 1;; p = eol + 1) {
+        eol = memchr(p, '\n', (size_t)(end - p));
+        if (!eol) return (size_t)(end - buf) > 65536 ? -1 : 0;
+        line_end = eol > p && eol[-1] == '\r' ? eol - 1 : eol;
+        if (line_end == p) break; // blank line: end of headers
+        const char *colon = memchr(p, ':', (size_t)(line_end - p));
+        if (!colon || req->header_count == NVX_MAX_HEADERS) return -1;
+        NVXHttpHeader *h = &req->headers[req->header_count++];
+        h->name.ptr = p;
+        h->name.len = (size_t)(colon - p);
+        const char *v = colon + 1;
+        while (v < line_end && (*v == ' ' || *v == '\t')) v++;
+        const char *ve = line_end;
+        while (ve > v && (ve[-1] == ' ' || ve[-1] == '\t')) ve--;
+        h->value.ptr = v;
+        h->value.len = (size_t)(ve - v);
+        if (span_is(h->name, "Content-Length")) body_len = strtoul(v, NULL, 10);
+        else if (span_is(h->name, "Transfer-Encoding")) chunked = 1;
+        else if (span_is(h->name, "Connection")) {
+            if (span_is(h->value, "close")) req->keep_alive = 0;
+            else if (span_is(h->value, "keep-alive")) req->keep_alive = 1;
+        }
+    }
+    size_t header_len = (size_t)(eol + 1 - buf);
+    if (chunked) return -2;
+    if (body_len > NVX_MAX_REQUEST) return -1;
+    if (len < header_len + body_len) return 0;
+    req->body.ptr = eol + 1;
+    req->body.len = body_len;
+    return (long)(header_len + body_len);
+}
+
+const NVXHttpSpan *nvx_request_header(const NVXHttpRequest *req, const char *name) {
+    for (int i = 0; i < req->header_count; ++i) {
+        if (span_is(req->headers[i].name, name)) return &req->headers[i].value;
+    }
+    return NULL;
+}
+
+static int reserve(char **buf, size_t *cap, size_t need) {
+    if (need <= *cap) return 0;
+    size_t ncap = *cap ? *cap : 1024;
+    while (ncap < need) ncap *= 2;
+    char *nb = realloc(*buf, ncap);
+    if (!nb) return -1;
+    *buf = nb;
+    *cap = ncap;
+    return 0;
+}
+
+void nvx_response_status(NVXHttpResponse *res, int status) {
+    res->status = status;
+}
+
+void nvx_response_type(NVXHttpResponse *res, const char *content_type) {
+    snprintf(res->content_type, sizeof(res->content_type), "%s", content_type ? content_type : "");
+}
+
+int nvx_response_header(NVXHttpResponse *res, const char *name, const char *value) {
+    size_t n = strlen(name) + strlen(value) + 4;
+    if (reserve(&res->head, &res->head_cap, res->head_len + n + 1) < 0) { res->failed = 1; return -1; }
+    res->head_len += (size_t)snprintf(res->head + res->head_len, n + 1, "%s: %s\r\n", name, value);
+    return 0;
+}
+
+int nvx_response_write(NVXHttpResponse *res, const void *data, size_t len) {
+    if (reserve(&res->body, &res->body_cap, res->body_len + len) < 0) { res->failed = 1; return -1; }
+    memcpy(res->body + res->body_len, data, len);
+    res->body_len += len;
+    return 0;
+}
+
+int nvx_response_printf(NVXHttpResponse *res, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n < 0 || reserve(&res->body, &res->body_cap, res->body_len + (size_t)n + 1) < 0) { res->failed = 1; return -1; }
+    va_start(ap, fmt);
+    vsnprintf(res->body + res->body_len, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    res->body_len += (size_t)n;
+    return 0;
+}
+
+int nvx_response_file(NVXHttpResponse *res, int fd, long long offset, size_t len) {
+#ifdef __linux__
+    if (res->file_fd >= 0) close(res->file_fd);
+    res->file_fd = fd;
+    res->file_off = offset;
+    res->file_len = len;
+    return 0;
+#else
+    res->body_len = 0;
+    int rc = reserve(&res->body, &res->body_cap, len) < 0 || lseek(fd, (long)offset, SEEK_SET) < 0 ? -1 : 0;
+    while (rc == 0 && res->body_len < len) {
+        int n = read(fd, res->body + res->body_len, (unsigned)(len - res->body_len));
+        if (n <= 0) rc = -1;
+        else res->body_len += (size_t)n;
+    }
+    close(fd);
+    if (rc < 0) res->failed = 1;
+    return rc;
+#endif
+}
+
+static const char *status_text(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 201: return "Created";
+    case 204: return "No Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 411: return "Length Required";
+    case 413: return "Payload Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    default: return "Unknown";
+    }
+}
+
+static void response_reset(NVXHttpResponse *res) {
+    if (res->file_fd >= 0) close(res->file_fd);
+    res->status = 200;
+    res->content_type[0] = '\0';
+    res->head_len = res->body_len = 0;
+    res->file_fd = -1;
+    res->failed = 0;
+}
+
+#ifdef __linux__
+// the file body of res after its headers went out
+static int send_file(int client, NVXHttpResponse *res) {
+    off_t off = (off_t)res->file_off;
+    size_t left = res->file_len;
+    while (left > 0) {
+        ssize_t sent = sendfile(client, res->file_fd, &off, left);
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            struct pollfd pfd = { .fd = client, .events = POLLOUT };
+            if (poll(&pfd, 1, idle_timeout * 1000) <= 0) return -1;
+            continue;
+        }
+        if (sent <= 0) return -1; // error, or the file shrank
+        left -= (size_t)sent;
+    }
+    return 0;
+}
+#endif
+
+// status line, headers and body in one gather write (then the file body,
+// if any); head_only drops the body of a HEAD reply but keeps its length
+static int send_response(int client, NVXHttpResponse *res, int keep_alive, int head_only) {
+    if (res->failed) {
+        response_reset(res);
+        res->status = 500;
+    }
+    int file = res->file_fd >= 0;
+    char line[256];
+    int n = snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", res->status, status_text(res->status));
+    if (res->status == 204 || res->status == 304) head_only = 1; // no body and no length
+    else n += snprintf(line + n, sizeof(line) - (size_t)n, "Content-Length: %zu\r\n", file ? res->file_len : res->body_len);
+    if (res->content_type[0]) n += snprintf(line + n, sizeof(line) - (size_t)n, "Content-Type: %s\r\n", res->content_type);
+    n += snprintf(line + n, sizeof(line) - (size_t)n, "Connection: %s\r\n", keep_alive ? "keep-alive" : "close");
+    NVXHttpSpan parts[4] = {
+        { line, (size_t)n }, { res->head, res->head_len }, { "\r\n", 2 },
+        { res->body, file || head_only ? 0 : res->body_len }
+    };
+    int rc = send_parts(client, parts, 4);
+#ifdef __linux__
+    if (rc == 0 && file && !head_only) rc = send_file(client, res);
+#endif
+    if (file) {
+        close(res->file_fd);
+        res->file_fd = -1;
+    }
+    if (res->body_cap > NVX_RESPONSE_KEEP) { // do not keep one huge reply's buffer around
+        free(res->body);
+        res->body = NULL;
+        res->body_cap = 0;
+    }
+    return rc;
+}
+
+// the reply being built on this thread; its buffers are reused
+static _Thread_local NVXHttpResponse reply = { .file_fd = -1 };
+
+// Response cache. Entries are spread over stripes by key hash; each stripe
+// has its own lock, hash chains, use-ordered list, share of the memory cap
+// and counters, so workers hitting different keys do not contend.
+#define CACHE_STRIPES 16
+#define CACHE_BUCKETS 256 // per stripe
+
+typedef struct CachedReply {
+    uint64_t hash;                          // method, path, query and body
+    long long expires;                      // monotonic milliseconds
+    size_t size;                            // bytes charged against the cap
+    struct CachedReply *chain;              // hash bucket
+    struct CachedReply *prev, *next;        // use order, most recent first
+    int status;
+    char content_type[96];
+    size_t method_len, path_len, query_len, body_len, head_len, reply_len;
+    char data[];                            // method, path, query, request body, headers, reply body
+} CachedReply;
+
+typedef struct {
+#ifdef __linux__
+    pthread_mutex_t lock;
+#endif
+    CachedReply *buckets[CACHE_BUCKETS];
+    CachedReply *head, *tail;
+    size_t bytes;
+    unsigned long long hits, misses;
+} CacheStripe;
+
+static CacheStripe stripes[CACHE_STRIPES];
+static size_t cache_cap = 16 * 1024 * 1024;
+
+#ifdef __linux__
+static pthread_once_t stripes_once = PTHREAD_ONCE_INIT;
+static void stripes_init(void) {
+    for (int i = 0; i < CACHE_STRIPES; ++i) pthread_mutex_init(&stripes[i].lock, NULL);
+}
+#define stripe_lock(s) (pthread_once(&stripes_once, stripes_init), pthread_mutex_lock(&(s)->lock))
+#define stripe_unlock(s) pthread_mutex_unlock(&(s)->lock)
+#else
+// the server here handles one request at a time
+#define stripe_lock(s) ((void)(s))
+#define stripe_unlock(s) ((void)(s))
+#endif
+
+static long long now_ms(void) {
+#ifdef _WIN32
+    return (long long)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+static uint64_t hash_bytes(uint64_t h, const char *p, size_t n) {
+    for (size_t i = 0; i < n; ++i) { // FNV-1a, 64 bit
+        h ^= (unsigned char)p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static uint64_t request_hash(const NVXHttpRequest *req) {
+    uint64_t h = 14695981039346656037ULL;
+    h = hash_bytes(h, req->method.ptr, req->method.len);
+    h = hash_bytes(h, " ", 1);
+    h = hash_bytes(h, req->path.ptr, req->path.len);
+    h = hash_bytes(h, "?", 1);
+    h = hash_bytes(h, req->query.ptr, req->query.len);
+    h = hash_bytes(h, "\n", 1);
+    return hash_bytes(h, req->body.ptr, req->body.len);
+}
+
+// the whole key is compared byte for byte: the hash only picks the bucket,
+// so a crafted collision cannot hand one client's reply to another
+static int cached_matches(const CachedReply *e, uint64_t hash, const NVXHttpRequest *req) {
+    const char *d = e->data;
+    return e->hash == hash &&
+           e->method_len == req->method.len && memcmp(d, req->method.ptr, e->method_len) == 0 &&
+           (d += e->method_len, e->path_len == req->path.len) && memcmp(d, req->path.ptr, e->path_len) == 0 &&
+           (d += e->path_len, e->query_len == req->query.len) && memcmp(d, req->query.ptr, e->query_len) == 0 &&
+           (d += e->query_len, e->body_len == req->body.len) && memcmp(d, req->body.ptr, e->body_len) == 0;
+}
+
+static void stripe_unlink(CacheStripe *s, CachedReply *e) {
+    if (e->prev) e->prev->next = e->next;
+    else s->head = e->next;
+    if (e->next) e->next->prev = e->prev;
+    else s->tail = e->prev;
+    e->prev = e->next = NULL;
+}
+
+static void stripe_push(CacheStripe *s, CachedReply *e) {
+    e->prev = NULL;
+    e->next = s->head;
+    if (s->head) s->head->prev = e;
+    else s->tail = e;
+    s->head = e;
+}
+
+static void stripe_remove(CacheStripe *s, CachedReply *e) {
+    CachedReply **pp = &s->buckets[(e->hash / CACHE_STRIPES) % CACHE_BUCKETS];
+    while (*pp != e) pp = &(*pp)->chain;
+    *pp = e->chain;
+    stripe_unlink(s, e);
+    s->bytes -= e->size;
+    free(e);
+}
+
+// fill res from the cache; 1 on a hit
+static int cache_lookup(uint64_t hash, const NVXHttpRequest *req, NVXHttpResponse *res) {
+    CacheStripe *s = &stripes[hash % CACHE_STRIPES];
+    int hit = 0;
+    stripe_lock(s);
+    CachedReply *e = s->buckets[(hash / CACHE_STRIPES) % CACHE_BUCKETS];
+    while (e && !cached_matches(e, hash, req)) e = e->chain;
+    if (e && e->expires <= now_ms()) {
+        stripe_remove(s, e);
+        e = NULL;
+    }
+    if (e) {
+        const char *head = e->data + e->method_len + e->path_len + e->query_len + e->body_len;
+        if (reserve(&res->head, &res->head_cap, e->head_len) == 0 &&
+            reserve(&res->body, &res->body_cap, e->reply_len) == 0) {
+            res->status = e->status;
+            memcpy(res->content_type, e->content_type, sizeof(res->content_type));
+            memcpy(res->head, head, e->head_len);
+            res->head_len = e->head_len;
+            memcpy(res->body, head + e->head_len, e->reply_len);
+            res->body_len = e->reply_len;
+            hit = 1;
+            stripe_unlink(s, e);
+            stripe_push(s, e);
+        }
+    }
+    if (hit) s->hits++;
+    else s->misses++;
+    stripe_unlock(s);
+    return hit;
+}
+
+static void cache_store(uint64_t hash, const NVXHttpRequest *req, const NVXHttpResponse *res, int ttl_ms) {
+    if (res->status != 200 || res->file_fd >= 0 || res->failed) return;
+    size_t n = req->method.len + req->path.len + req->query.len + req->body.len + res->head_len + res->body_len;
+    size_t size = sizeof(CachedReply) + n;
+    size_t cap = cache_cap / CACHE_STRIPES;
+    if (size > cap) return;
+    CachedReply *e = malloc(size);
+    if (!e) return;
+    e->hash = hash;
+    e->expires = now_ms() + ttl_ms;
+    e->size = size;
+    e->status = res->status;
+    memcpy(e->content_type, res->content_type, sizeof(e->content_type));
+    e->method_len = req->method.len;
+    e->path_len = req->path.len;
+    e->query_len = req->query.len;
+    e->body_len = req->body.len;
+    e->head_len = res->head_len;
+    e->reply_len = res->body_len;
+    char *d = e->data;
+    memcpy(d, req->method.ptr, req->method.len); d += req->method.len;
+    memcpy(d, req->path.ptr, req->path.len); d += req->path.len;
+    memcpy(d, req->query.ptr, req->query.len); d += req->query.len;
+    if (req->body.len) memcpy(d, req->body.ptr, req->body.len);
+    d += req->body.len;
+    if (res->head_len) memcpy(d, res->head, res->head_len);
+    d += res->head_len;
+    if (res->body_len) memcpy(d, res->body, res->body_len);
+    CacheStripe *s = &stripes[hash % CACHE_STRIPES];
+    CachedReply **bucket = &s->buckets[(hash / CACHE_STRIPES) % CACHE_BUCKETS];
+    stripe_lock(s);
+    for (CachedReply *old = *bucket; old; old = old->chain) {
+        if (cached_matches(old, hash, req)) { stripe_remove(s, old); break; } // stored by another worker meanwhile
+    }
+    e->chain = *bucket;
+    *bucket = e;
+    stripe_push(s, e);
+    s->bytes += size;
+    while (s->bytes > cap && s->tail) stripe_remove(s, s->tail);
+    stripe_unlock(s);
+}
+
+void nvx_set_response_cache(size_t max_bytes) {
+    cache_cap = max_bytes;
+    for (int i = 0; i < CACHE_STRIPES; ++i) {
+        CacheStripe *s = &stripes[i];
+        stripe_lock(s);
+        while (s->bytes > cache_cap / CACHE_STRIPES && s->tail) stripe_remove(s, s->tail);
+        stripe_unlock(s);
+    }
+}
+
+void nvx_response_cache_stats(unsigned long long *hits, unsigned long long *misses, size_t *bytes) {
+    unsigned long long h = 0, m = 0;
+    size_t b = 0;
+    for (int i = 0; i < CACHE_STRIPES; ++i) {
+        CacheStripe *s = &stripes[i];
+        stripe_lock(s);
+        h += s->hits;
+        m += s->misses;
+        b += s->bytes;
+        stripe_unlock(s);
+    }
+    if (hits) *hits = h;
+    if (misses) *misses = m;
+    if (bytes) *bytes = b;
+}
+
+// run the matching handler for a parsed request of len bytes at buf and
+// send the response; returns -1 if the connection broke while writing
+static int handle_request(int client, char *buf, size_t len, NVXHttpRequest *req, int keep_alive) {
+    char saved = buf[len];
+    buf[len] = '\0'; // the body may be read as a C string
+    response_reset(&reply);
+    const Route *r = router ? nvx_router_find(router, req->method.ptr, req->method.len,
+                                              req->path.ptr, req->path.len, &req->params) : NULL;
+    uint64_t hash = r && r->cache_ms ? request_hash(req) : 0;
+    if (!r) {
+        reply.status = 404;
+    } else if (!r->cache_ms || !cache_lookup(hash, req, &reply)) {
+        if (r->http_handler) {
+            r->http_handler(req, &reply, r->data);
+        } else {
+            char response[NVX_RESPONSE_SIZE] = "";
+            r->handler(req->body.ptr, response, sizeof(response));
+            nvx_response_write(&reply, response, strlen(response));
+        }
+        if (r->cache_ms) cache_store(hash, req, &reply, r->cache_ms);
+    }
+    buf[len] = saved;
+    int head_only = req->method.len == 4 && memcmp(req->method.ptr, "HEAD", 4) == 0;
+    return send_response(client, &reply, keep_alive, head_only);
+}
+
+// answer a request that could not be parsed (parse_request result n < 0);
+// the connection is closed after
+static void reject_request(int client, long n) {
+    response_reset(&reply);
+    reply.status = n == -2 ? 501 : 400;
+    send_response(client, &reply, 0, 0);
+}
+
+#ifdef __linux__
+
+// Event loop: the main thread accepts and reads non-blocking sockets via
+// epoll, buffering partial requests per connection. Complete requests are
+// queued to a pool of worker threads that run the handlers and reply, then
+// hand persistent connections back to the loop. Sockets are registered
+// EPOLLONESHOT so a connection is owned by exactly one thread at a time.
+
+typedef struct Conn {
+    int fd;
+    char *buf;
+    size_t len, cap;
+    int served;                   // requests answered on this connection
+    time_t last_active;
+    struct Conn *next;            // work queue link
+    struct Conn *idle_prev, *idle_next; // idle list link, while waiting in epoll
+} Conn;
+
+static int epoll_fd = -1;
+static Conn *queue_head, *queue_tail;
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_ready = PTHREAD_COND_INITIALIZER;
+
+// connections parked in epoll, oldest activity first, for the idle sweep
+static Conn *idle_head, *idle_tail;
+static pthread_mutex_t idle_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void conn_free(Conn *c) {
+    close(c->fd);
+    free(c->buf);
+    free(c);
+}
+
+static void idle_unlink(Conn *c) {
+    if (c->idle_prev) c->idle_prev->idle_next = c->idle_next;
+    else idle_head = c->idle_next;
+    if (c->idle_next) c->idle_next->idle_prev = c->idle_prev;
+    else idle_tail = c->idle_prev;
+    c->idle_prev = c->idle_next = NULL;
+}
+
+// park a connection: append to the idle list and re-arm its oneshot event
+static int conn_wait(Conn *c, int op) {
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT, .data.ptr = c };
+    pthread_mutex_lock(&idle_lock);
+    c->idle_prev = idle_tail;
+    c->idle_next = NULL;
+    if (idle_tail) idle_tail->idle_next = c;
+    else idle_head = c;
+    idle_tail = c;
+    int rc = epoll_ctl(epoll_fd, op, c->fd, &ev);
+    if (rc < 0) idle_unlink(c);
+    pthread_mutex_unlock(&idle_lock);
+    return rc;
+}
+
+// close connections that have been idle longer than the timeout
+static void sweep_idle(time_t now) {
+    pthread_mutex_lock(&idle_lock);
+    while (idle_head && now - idle_head->last_active >= idle_timeout) {
+        Conn *c = idle_head;
+        idle_unlink(c);
+        conn_free(c); // closing the fd also removes it from epoll
+    }
+    pthread_mutex_unlock(&idle_lock);
+}
+
+static void enqueue(Conn *c) {
+    c->next = NULL;
+    pthread_mutex_lock(&queue_lock);
+    if (queue_tail) queue_tail->next = c;
+    else queue_head = c;
+    queue_tail = c;
+    pthread_cond_signal(&queue_ready);
+    pthread_mutex_unlock(&queue_lock);
+}
+
+// answer every complete request in the buffer, in order (pipelining);
+// returns 1 to keep the connection, 0 to close it
+static int conn_serve(Conn *c) {
+    size_t off = 0;
+    long n;
+    NVXHttpRequest req;
+    while ((n = parse_request(c->buf + off, c->len - off, &req)) != 0) {
+        if (n < 0) { reject_request(c->fd, n); return 0; }
+        int keep = req.keep_alive;
+        if (++c->served >= max_keepalive) keep = 0;
+        if (handle_request(c->fd, c->buf + off, (size_t)n, &req, keep) < 0) return 0;
+        off += (size_t)n;
+        if (!keep) return 0;
+    }
+    memmove(c->buf, c->buf + off, c->len - off);
+    c->len -= off;
+    c->last_active = time(NULL);
+    return 1;
+}
+
+static void *worker_main(void *arg) {
+    if (worker_init) worker_init((int)(intptr_t)arg);
+    for (;;) {
+        pthread_mutex_lock(&queue_lock);
+        while (!queue_head) pthread_cond_wait(&queue_ready, &queue_lock);
+        Conn *c = queue_head;
+        queue_head = c->next;
+        if (!queue_head) queue_tail = NULL;
+        pthread_mutex_unlock(&queue_lock);
+        if (!conn_serve(c) || conn_wait(c, EPOLL_CTL_MOD) < 0) conn_free(c);
+    }
+    return NULL;
+}
+
+// read what is available; returns 1 when a full request is buffered,
+// 0 if more data is needed, -1 if the connection should be dropped
+static int conn_read(Conn *c) {
+    NVXHttpRequest req;
+    for (;;) {
+        if (c->len + 1 >= c->cap) {
+            if (c->cap >= NVX_MAX_REQUEST) return -1;
+            size_t ncap = c->cap ? c->cap * 2 : 4096;
+            char *nb = realloc(c->buf, ncap);
+            if (!nb) return -1;
+            c->buf = nb;
+            c->cap = ncap;
+        }
+        ssize_t r = recv(c->fd, c->buf + c->len, c->cap - c->len - 1, 0);
+        if (r > 0) { c->len += (size_t)r; continue; }
+        if (r == 0) return c->len > 0 && parse_request(c->buf, c->len, &req) != 0 ? 1 : -1;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        return -1;
+    }
+    c->last_active = time(NULL);
+    return parse_request(c->buf, c->len, &req) != 0; // malformed requests go to a worker for the 400 or 501
+}
+
+static int start_workers(void) {
+    int n = nvx_server_worker_count();
+    for (int i = 0; i < n; ++i) {
+        pthread_t t;
+        if (pthread_create(&t, NULL, worker_main, (void *)(intptr_t)i) != 0) return i > 0 ? i : -1;
+        pthread_detach(t);
+    }
+    return n;
 }
 
-static void handle_connection(int client) {
-    char buf[8192];
-    int r = recv(client, buf, sizeof(buf)-1, 0);
-    if (r <= 0) return;
-    buf[r] = '\0';
-    // parse first line: METHOD PATH ...
-    char method[16], path[256];
-    sscanf(buf, "%15s %255s", method, path);
-    // find handler
-    for (int i = 0; i < route_count; i++) {
-        if (strcmp(path, route_paths[i]) == 0) {
-            char response[4096] = "";
-            // locate body (after blank line)
-            char *body = strstr(buf, "\r\n\r\n");
-            if (body) body += 4;
-            route_handlers[i](body?body: "", response, sizeof(response));
-            char header[512];
-            snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\nContent-Length: %zu\r\n\r\n", strlen(response));
-            send(client, header, strlen(header), 0);
-            send(client, response, strlen(response), 0);
+int nvx_run_server(const char *port) {
+    int listener = create_listener(port);
+    if (listener < 0) return -1;
+    fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) { close(listener); return -1; }
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL }; // NULL marks the listener
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listener, &ev);
+    int workers = start_workers();
+    if (workers < 0) { close(epoll_fd); close(listener); return -1; }
+    printf("NVX server listening on port %s (%d workers)\n", port, workers);
+    struct epoll_event events[64];
+    time_t last_sweep = time(NULL);
+    for (;;) {
+        int n = epoll_wait(epoll_fd, events, 64, 1000);
+        if (n < 0) {
+            if (errno == EINTR) continue;
             break;
         }
+        for (int i = 0; i < n; ++i) {
+            Conn *c = events[i].data.ptr;
+            if (!c) {
+                int client;
+                while ((client = accept4(listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    Conn *nc = calloc(1, sizeof(Conn));
+                    if (!nc) { close(client); continue; }
+                    nc->fd = client;
+                    nc->last_active = time(NULL);
+                    if (conn_wait(nc, EPOLL_CTL_ADD) < 0) conn_free(nc);
+                }
+                continue;
+            }
+            pthread_mutex_lock(&idle_lock);
+            idle_unlink(c);
+            pthread_mutex_unlock(&idle_lock);
+            int state = conn_read(c);
+            if (state > 0) enqueue(c);
+            else if (state < 0 || conn_wait(c, EPOLL_CTL_MOD) < 0) conn_free(c);
+        }
+        time_t now = time(NULL);
+        if (now != last_sweep) {
+            sweep_idle(now);
+            last_sweep = now;
+        }
     }
+    close(epoll_fd);
+    close(listener);
+    return 0;
 }
 
+#else
+
+// portable fallback: one connection at a time, so connections are closed
+// after the requests already received (including pipelined ones) are answered
 int nvx_run_server(const char *port) {
 #ifdef _WIN32
     WSADATA wsa;
@@ -85,26 +871,35 @@ int nvx_run_server(const char *port) {
     int listener = create_listener(port);
     if (listener < 0) return -1;
     printf("NVX server listening on port %s\n", port);
-    while (1) {
-        int client;
-#ifdef _WIN32
-        client = accept(listener, NULL, NULL);
-#else
-        client = accept(listener, NULL, NULL);
-#endif
+    if (worker_init) worker_init(0);
+    char *buf = malloc(NVX_MAX_REQUEST + 1);
+    while (buf) {
+        int client = accept(listener, NULL, NULL);
         if (client < 0) break;
-        handle_connection(client);
-#ifdef _WIN32
-        closesocket(client);
-#else
-        close(client);
+#ifndef _WIN32
+        fcntl(client, F_SETFD, FD_CLOEXEC);
 #endif
+        NVXHttpRequest req;
+        size_t len = 0;
+        long n = 0;
+        int r;
+        while (!n && len < NVX_MAX_REQUEST && (r = recv(client, buf + len, (int)(NVX_MAX_REQUEST - len), 0)) > 0) {
+            len += (size_t)r;
+            n = parse_request(buf, len, &req);
+        }
+        for (size_t off = 0; n; n = parse_request(buf + off, len - off, &req)) {
+            if (n < 0) { reject_request(client, n); break; }
+            if (handle_request(client, buf + off, (size_t)n, &req, 0) < 0) break;
+            off += (size_t)n;
+        }
+        close_socket(client);
     }
+    free(buf);
+    close_socket(listener);
 #ifdef _WIN32
-    closesocket(listener);
     WSACleanup();
-#else
-    close(listener);
 #endif
     return 0;
 }
+
+#endif
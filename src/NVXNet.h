@@ -2,15 +2,104 @@
 #define NVX_NET_H
 
 #include <stddef.h>
+#include "NVXRouter.h"
 
 // minimalist HTTP server. Register a handler for a path.
-// Handler receives request body (for POST), and must fill response buffer.
+// The simple handler receives the request body (for POST) and must fill the
+// response buffer (at most resp_size bytes, sent as status 200).
 
 typedef void (*nvx_route_handler)(const char *body, char *response, size_t resp_size);
 
-// register route; path should begin with '/'
+// register route for any method; path should begin with '/'
 void nvx_register_route(const char *path, nvx_route_handler handler);
 
+// A parsed request. Every span points into the server's receive buffer and
+// is valid only during the handler call; nothing is copied. The body is
+// followed by a NUL, so it may also be used as a C string.
+typedef struct { const char *ptr; size_t len; } NVXHttpSpan;
+typedef struct { NVXHttpSpan name, value; } NVXHttpHeader;
+
+#define NVX_MAX_HEADERS 32
+
+typedef struct {
+    NVXHttpSpan method, path, query, version; // query: after '?', without it
+    NVXHttpHeader headers[NVX_MAX_HEADERS];
+    int header_count;
+    NVXHttpSpan body;
+    NVXParams params;                         // captures of the matching route
+    int keep_alive;
+} NVXHttpRequest;
+
+// value of a header (name compared without case), NULL if absent
+const NVXHttpSpan *nvx_request_header(const NVXHttpRequest *req, const char *name);
+
+// The reply a handler builds: status 200 and no Content-Type unless set.
+// Buffers grow as needed and are reused by the worker for its next request.
+// Status line, headers and body are sent with one gather write. Replies to
+// HEAD requests carry the headers only.
+typedef struct {
+    int status;
+    char content_type[96];
+    char *head; size_t head_len, head_cap;    // extra header lines
+    char *body; size_t body_len, body_cap;
+    int file_fd; long long file_off; size_t file_len; // body sent from a file, see nvx_response_file
+    int failed;                               // out of memory: sent as a 500
+} NVXHttpResponse;
+
+void nvx_response_status(NVXHttpResponse *res, int status);
+void nvx_response_type(NVXHttpResponse *res, const char *content_type);
+// add a header line; Content-Length and Connection are set by the server.
+// The write functions append to the body. All return 0, or -1 when out of memory.
+int nvx_response_header(NVXHttpResponse *res, const char *name, const char *value);
+int nvx_response_write(NVXHttpResponse *res, const void *data, size_t len);
+int nvx_response_printf(NVXHttpResponse *res, const char *fmt, ...);
+// send len bytes of the open file fd from offset as the body (instead of
+// anything written). The server owns fd from here on and closes it. On Linux
+// the file goes out with sendfile(2) without passing through user space;
+// elsewhere it is read into the body right away.
+int nvx_response_file(NVXHttpResponse *res, int fd, long long offset, size_t len);
+
+typedef void (*nvx_http_handler)(const NVXHttpRequest *req, NVXHttpResponse *res, void *data);
+
+// route pattern for one method ("GET", ...; NULL = any), with `:name` and
+// `*name` segments as described in NVXRouter.h; data is passed to the
+// handler. Returns 0, or -1 if the pattern is malformed or clashes with an
+// earlier route.
+int nvx_add_route(const char *method, const char *pattern, nvx_http_handler handler, void *data);
+
+// Response cache for routes whose output depends only on the request: the
+// same as nvx_add_route, but a 200 reply is kept for ttl_ms milliseconds and
+// repeated requests with the same method, path, query and body are answered
+// from memory without calling the handler. Replies sent from a file are not
+// cached.
+int nvx_add_cached_route(const char *method, const char *pattern, nvx_http_handler handler,
+                         void *data, int ttl_ms);
+
+// memory the response cache may hold (default 16 MB); the oldest entries go first
+void nvx_set_response_cache(size_t max_bytes);
+
+// lookups answered from the cache, lookups that ran the handler, bytes held
+// (any pointer may be NULL)
+void nvx_response_cache_stats(unsigned long long *hits, unsigned long long *misses, size_t *bytes);
+
+// number of worker threads running handlers (0 = one per CPU with a minimum of 4, the default).
+// On Linux the server multiplexes connections with epoll and hands complete
+// requests to the workers; elsewhere it serves one connection at a time.
+void nvx_set_server_workers(int workers);
+
+// the number of workers nvx_run_server will start (1 where it serves one
+// connection at a time)
+int nvx_server_worker_count(void);
+
+// called on each worker thread with its index (0 .. count-1) before it takes
+// a request, so handlers can keep per-worker state
+void nvx_set_worker_init(void (*init)(int worker));
+
+// HTTP/1.1 persistent connections: close a connection after idle_seconds
+// without a request (default 5) or after max_requests answers (default 100;
+// 1 disables keep-alive).
+void nvx_set_server_keepalive(int idle_seconds, int max_requests);
+
 // start server on given port (string, e.g. "8080"). This call blocks until terminated.
 int nvx_run_server(const char *port);
 
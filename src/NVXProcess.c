@@ -0,0 +1,264 @@
+#define _GNU_SOURCE // pipe2
+#include "NVXProcess.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+extern char **environ;
+#endif
+
+// Children are started with posix_spawn (vfork + exec in glibc) instead of
+// system(), so no copy of the interpreter and no shell is made per command.
+// Handles index a growable table, one per thread so interpreters running in
+// parallel keep their children apart; a slot is reused once its process has
+// been waited for. On Windows commands run to completion inside spawn (through
+// cmd.exe) and wait only hands back the result.
+
+typedef struct {
+    int used;
+    int fd;           // read end of the capture pipe, -1 when not capturing or at EOF
+    char *out; size_t len, cap;
+#ifdef _WIN32
+    int status;       // exit code, known when spawn returns
+#else
+    pid_t pid;
+#endif
+} Proc;
+
+static _Thread_local Proc *procs = NULL;
+static _Thread_local int proc_count = 0, proc_cap = 0;
+
+static int new_slot(void) {
+    for (int i = 0; i < proc_count; ++i) {
+        if (!procs[i].used) return i;
+    }
+    if (proc_count == proc_cap) {
+        int ncap = proc_cap ? proc_cap * 2 : 16;
+        Proc *np = realloc(procs, (size_t)ncap * sizeof(Proc));
+        if (!np) return -1;
+        procs = np;
+        proc_cap = ncap;
+    }
+    return proc_count++;
+}
+
+static int append_output(Proc *p, const char *data, size_t n) {
+    if (p->len + n + 1 > p->cap) {
+        size_t ncap = p->cap ? p->cap : 4096;
+        while (ncap < p->len + n + 1) ncap *= 2;
+        char *nb = realloc(p->out, ncap);
+        if (!nb) return 0;
+        p->out = nb;
+        p->cap = ncap;
+    }
+    memcpy(p->out + p->len, data, n);
+    p->len += n;
+    p->out[p->len] = '\0';
+    return 1;
+}
+
+static void release_slot(Proc *p) {
+    free(p->out);
+    p->out = NULL;
+    p->used = 0;
+}
+
+#ifdef _WIN32
+
+int nvx_process_spawn(const char *cmd, int flags) {
+    if (!cmd || !*cmd) return -1;
+    int i = new_slot();
+    if (i < 0) return -1;
+    Proc *p = &procs[i];
+    memset(p, 0, sizeof(*p));
+    p->used = 1;
+    p->fd = -1;
+    fflush(stdout);
+    if (flags & NVX_PROC_CAPTURE) {
+        FILE *f = _popen(cmd, "r");
+        if (!f) { p->used = 0; return -1; }
+        char chunk[4096];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) append_output(p, chunk, n);
+        p->status = _pclose(f);
+    } else {
+        p->status = system(cmd);
+    }
+    return i + 1;
+}
+
+int nvx_process_wait(int handle, char **out, size_t *len) {
+    if (handle < 1 || handle > proc_count || !procs[handle-1].used) return -1;
+    Proc *p = &procs[handle-1];
+    int code = p->status;
+    if (out) {
+        if (!p->out) p->out = calloc(1, 1);
+        *out = p->out;
+        if (len) *len = p->len;
+        p->out = NULL;
+    }
+    release_slot(p);
+    return code;
+}
+
+#else
+
+// split a command line into words: blanks separate, "..." and '...' group,
+// a backslash escapes the next character (not inside '...'). The pointer
+// array and the text share one allocation.
+static char **split_words(const char *cmd) {
+    size_t n = strlen(cmd);
+    size_t slots = n / 2 + 2; // at most one word per two characters, plus NULL
+    char **argv = malloc(slots * sizeof(char *) + n + slots);
+    if (!argv) return NULL;
+    char *buf = (char *)(argv + slots);
+    int argc = 0;
+    const char *p = cmd;
+    while (*p) {
+        while (*p && isspace((unsigned char)*p)) p++;
+        if (!*p) break;
+        argv[argc++] = buf;
+        char quote = 0;
+        while (*p && (quote || !isspace((unsigned char)*p))) {
+            if (quote && *p == quote) { quote = 0; p++; continue; }
+            if (!quote && (*p == '"' || *p == '\'')) { quote = *p++; continue; }
+            if (*p == '\\' && p[1] && quote != '\'') p++;
+            *buf++ = *p++;
+        }
+        *buf++ = '\0';
+    }
+    argv[argc] = NULL;
+    return argv;
+}
+
+int nvx_process_spawn(const char *cmd, int flags) {
+    if (!cmd) return -1;
+    char *sh_argv[] = { "/bin/sh", "-c", (char *)cmd, NULL };
+    char **words = (flags & NVX_PROC_SHELL) ? NULL : split_words(cmd);
+    char **argv = (flags & NVX_PROC_SHELL) ? sh_argv : words;
+    if (!argv || !argv[0]) { free(words); return -1; }
+    int i = new_slot();
+    if (i < 0) { free(words); return -1; }
+    Proc *p = &procs[i];
+    memset(p, 0, sizeof(*p));
+    p->fd = -1;
+    int pipefd[2] = { -1, -1 };
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    if (flags & NVX_PROC_CAPTURE) {
+        // both ends are close-on-exec from the start, so a child spawned by
+        // another thread at the same moment cannot inherit them; adddup2
+        // clears the flag on the child's 1 and 2
+        if (pipe2(pipefd, O_CLOEXEC) != 0) { posix_spawn_file_actions_destroy(&fa); free(words); return -1; }
+        posix_spawn_file_actions_adddup2(&fa, pipefd[1], 1);
+        posix_spawn_file_actions_adddup2(&fa, pipefd[1], 2);
+        posix_spawn_file_actions_addclose(&fa, pipefd[1]);
+    }
+    fflush(stdout); // keep the script's own output ahead of the child's
+    int rc = posix_spawnp(&p->pid, argv[0], &fa, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&fa);
+    if (pipefd[1] >= 0) close(pipefd[1]);
+    if (rc != 0) {
+        printf("NVD Error: Could not start '%s': %s\n", argv[0], strerror(rc));
+        if (pipefd[0] >= 0) close(pipefd[0]);
+        free(words);
+        return -1;
+    }
+    free(words);
+    p->used = 1;
+    p->fd = pipefd[0];
+    return i + 1;
+}
+
+// read what captured children have written until `target`'s pipe is at EOF
+// (target < 0: until every pipe is)
+static void drain(int target) {
+    struct pollfd *fds = NULL;
+    int *owner = NULL;
+    for (;;) {
+        if (target >= 0 && procs[target].fd < 0) break;
+        if (!fds) {
+            fds = malloc((size_t)proc_count * sizeof(struct pollfd));
+            owner = malloc((size_t)proc_count * sizeof(int));
+            if (!fds || !owner) break;
+        }
+        int n = 0;
+        for (int i = 0; i < proc_count; ++i) {
+            if (!procs[i].used || procs[i].fd < 0) continue;
+            fds[n].fd = procs[i].fd;
+            fds[n].events = POLLIN;
+            owner[n++] = i;
+        }
+        if (n == 0) break;
+        if (poll(fds, (nfds_t)n, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int k = 0; k < n; ++k) {
+            if (!fds[k].revents) continue;
+            Proc *p = &procs[owner[k]];
+            char chunk[16384];
+            ssize_t got = read(p->fd, chunk, sizeof(chunk));
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0 || !append_output(p, chunk, (size_t)got)) {
+                close(p->fd);
+                p->fd = -1;
+            }
+        }
+    }
+    free(fds);
+    free(owner);
+}
+
+int nvx_process_wait(int handle, char **out, size_t *len) {
+    if (handle < 1 || handle > proc_count || !procs[handle-1].used) return -1;
+    int i = handle - 1;
+    drain(i);
+    Proc *p = &procs[i];
+    if (p->fd >= 0) { close(p->fd); p->fd = -1; }
+    int st = 0, code = -1;
+    while (waitpid(p->pid, &st, 0) < 0) {
+        if (errno != EINTR) { st = -1; break; }
+    }
+    if (st != -1) {
+        if (WIFEXITED(st)) code = WEXITSTATUS(st);
+        else if (WIFSIGNALED(st)) code = 128 + WTERMSIG(st);
+    }
+    if (out) {
+        if (!p->out) p->out = calloc(1, 1);
+        *out = p->out;
+        if (len) *len = p->len;
+        p->out = NULL;
+    }
+    release_slot(p);
+    return code;
+}
+
+#endif
+
+int nvx_process_wait_all(void) {
+#ifndef _WIN32
+    drain(-1);
+#endif
+    int failed = 0;
+    for (int i = 0; i < proc_count; ++i) {
+        if (procs[i].used && nvx_process_wait(i + 1, NULL, NULL) != 0) failed++;
+    }
+    return failed;
+}
+
+int nvx_process_run(const char *cmd, int flags, char **out, size_t *len) {
+    int h = nvx_process_spawn(cmd, flags);
+    if (h < 0) return -1;
+    return nvx_process_wait(h, out, len);
+}
@@ -0,0 +1,32 @@
+#ifndef NVX_PROCESS_H
+#define NVX_PROCESS_H
+
+#include <stddef.h>
+
+// child processes started with posix_spawn. Without NVX_PROC_SHELL the
+// command line is split into words (double or single quotes group, a
+// backslash escapes the next character) and the program is searched in PATH;
+// no shell is started. With NVX_PROC_CAPTURE stdout and stderr go into a pipe
+// and are collected while waiting.
+#define NVX_PROC_SHELL   1 // run through /bin/sh -c (cmd.exe on Windows)
+#define NVX_PROC_CAPTURE 2
+
+// start cmd; returns a handle (> 0) or -1 if it could not be started. Handles
+// are private to the calling thread: wait for them on the thread that spawned.
+int nvx_process_spawn(const char *cmd, int flags);
+
+// wait for a handle and release it. Returns the exit code (128+signal when
+// killed, -1 for an unknown handle). Until a captured handle's output is
+// complete, the pipes of all captured processes are drained together, so
+// siblings do not stall on a full pipe meanwhile. If out
+// is not NULL it receives the captured output (malloc'd, NUL-terminated,
+// caller frees; an empty string without NVX_PROC_CAPTURE) and *len its length.
+int nvx_process_wait(int handle, char **out, size_t *len);
+
+// wait for every process still running; returns how many exited non-zero
+int nvx_process_wait_all(void);
+
+// spawn and wait in one call; -1 if cmd could not be started
+int nvx_process_run(const char *cmd, int flags, char **out, size_t *len);
+
+#endif // NVX_PROCESS_H
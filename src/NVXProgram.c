@@ -0,0 +1,989 @@
+#include "NVXProgram.h"
+#include "NVXScript.h"
+#include "NVXVars.h"
+#include "NVXContext.h"
+#include "NVXMath.h"
+#include "NVXLex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+
+// forward jumps waiting for a target that is not known yet
+typedef struct { int *at; int len, cap; } JumpList;
+
+// jumps emitted for break/continue inside the innermost loop, patched once
+// the loop's continue and exit targets are known
+typedef struct LoopCtx {
+    JumpList breaks, conts;
+    struct LoopCtx *outer;
+} LoopCtx;
+
+// offsets of a `{` and its matching `}` (len of the source if unclosed)
+typedef struct { size_t open, close; } BracePair;
+
+// Compiler: walks the source in place (often a read-only file mapping) with a
+// cursor that may stop mid-line (`} else {`, `{ print(x) }`). Nothing is
+// NUL-terminated: a line ends at '\n', '\r' or '\0', the source at len.
+typedef struct {
+    NVXProgram *prog;
+    const char *src;  // script text, named block bodies are captured from it
+    size_t len;
+    size_t pos;       // cursor into src
+    int failed;
+    LoopCtx *loop;    // innermost enclosing loop, NULL outside loops
+    size_t *lines;    // offset of each line start, built once for error positions
+    int nlines;
+    BracePair *braces; // every `{` with its matching `}`, ordered by opening offset
+    int nbraces;
+} Compiler;
+
+// report a script error at the cursor's line
+static void compile_error(Compiler *c, const char *fmt, ...) {
+    int lo = 0, hi = c->nlines - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (c->lines[mid] <= c->pos) lo = mid;
+        else hi = mid - 1;
+    }
+    va_list ap;
+    va_start(ap, fmt);
+    printf("NVD Error: line %d: ", lo + 1);
+    vprintf(fmt, ap);
+    printf("\n");
+    va_end(ap);
+}
+
+static int grow(void **arr, int *cap, int need, size_t elem) {
+    if (need <= *cap) return 1;
+    int ncap = *cap ? *cap * 2 : 16;
+    while (ncap < need) ncap *= 2;
+    void *p = nvx_realloc(*arr, (size_t)ncap * elem);
+    if (!p) return 0;
+    *arr = p; *cap = ncap;
+    return 1;
+}
+
+static void add_jump(Compiler *c, JumpList *l, int at) {
+    if (at < 0) return;
+    if (!grow((void **)&l->at, &l->cap, l->len + 1, sizeof(int))) { c->failed = 1; return; }
+    l->at[l->len++] = at;
+}
+
+static int is_line_end(char ch) { return ch == '\n' || ch == '\r' || ch == '\0'; }
+
+// end of the line p is on
+static const char *line_end(const Compiler *c, const char *p) {
+    const char *end = c->src + c->len;
+    while (p < end && !is_line_end(*p)) p++;
+    return p;
+}
+
+// pre-pass: pair every brace outside strings and comment lines once, so block
+// bodies are known as spans before they are compiled
+static int match_braces(Compiler *c) {
+    int *stack = NULL, depth = 0, stack_cap = 0, brace_cap = 0;
+    int at_line_start = 1, inq = 0;
+    for (size_t i = 0; i < c->len; ++i) {
+        char ch = c->src[i];
+        if (is_line_end(ch)) { at_line_start = 1; inq = 0; continue; }
+        if (at_line_start && isspace((unsigned char)ch)) continue;
+        if (at_line_start && ch == '#') { i = (size_t)(line_end(c, c->src + i) - c->src) - 1; continue; }
+        at_line_start = 0;
+        if (inq) {
+            if (ch == '\\' && i + 1 < c->len && !is_line_end(c->src[i+1])) i++;
+            else if (ch == '"') inq = 0;
+        } else if (ch == '"') {
+            inq = 1;
+        } else if (ch == '{') {
+            if (!grow((void **)&c->braces, &brace_cap, c->nbraces + 1, sizeof(BracePair)) ||
+                !grow((void **)&stack, &stack_cap, depth + 1, sizeof(int))) {
+                free(stack); return 0;
+            }
+            c->braces[c->nbraces].open = i;
+            c->braces[c->nbraces].close = c->len;
+            stack[depth++] = c->nbraces++;
+        } else if (ch == '}' && depth > 0) {
+            c->braces[stack[--depth]].close = i;
+        }
+    }
+    while (depth > 0) {
+        c->pos = c->braces[stack[--depth]].open;
+        compile_error(c, "missing } for the block opened here.");
+    }
+    c->pos = 0;
+    free(stack);
+    return 1;
+}
+
+// matching `}` of the `{` at offset open
+static size_t brace_close(const Compiler *c, size_t open) {
+    int lo = 0, hi = c->nbraces - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (c->braces[mid].open == open) return c->braces[mid].close;
+        if (c->braces[mid].open < open) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return c->len;
+}
+
+static int emit(Compiler *c, int op, int mode, int a, int b, int cc) {
+    NVXProgram *p = c->prog;
+    if (!grow((void **)&p->code, &p->code_cap, p->code_len + 1, sizeof(NVXInstr))) { c->failed = 1; return -1; }
+    NVXInstr *in = &p->code[p->code_len];
+    in->op = (unsigned char)op; in->mode = (unsigned char)mode;
+    in->a = a; in->b = b; in->c = cc;
+    return p->code_len++;
+}
+
+// add a string to the program pool; operand text is already trimmed by the caller
+static int add_str(Compiler *c, const char *s, size_t n) {
+    NVXProgram *p = c->prog;
+    char *copy = nvx_arena_strndup(&p->strings, s, n);
+    if (!copy || !grow((void **)&p->strs, &p->str_cap, p->str_len + 1, sizeof(char *))) {
+        c->failed = 1; return 0;
+    }
+    p->strs[p->str_len] = copy;
+    return p->str_len++;
+}
+
+static int add_cstr(Compiler *c, const char *s) { return add_str(c, s, strlen(s)); }
+
+static int find_block(Compiler *c, const char *name, size_t n) {
+    NVXProgram *p = c->prog;
+    for (int i = 0; i < p->block_len; ++i) {
+        const char *bn = p->strs[p->blocks[i].name];
+        if (strncmp(bn, name, n) == 0 && bn[n] == '\0') return i;
+    }
+    if (!grow((void **)&p->blocks, &p->block_cap, p->block_len + 1, sizeof(NVXBlock))) { c->failed = 1; return 0; }
+    p->blocks[p->block_len].name = add_str(c, name, n);
+    p->blocks[p->block_len].start = -1;
+    p->blocks[p->block_len].stored = 0;
+    return p->block_len++;
+}
+
+// character i of the text [s, end), '\0' past its end
+static char char_at(const char *s, const char *end, size_t i) {
+    return i < (size_t)(end - s) ? s[i] : '\0';
+}
+
+static int starts_with(const char *s, const char *end, const char *prefix) {
+    size_t n = strlen(prefix);
+    return (size_t)(end - s) >= n && memcmp(s, prefix, n) == 0;
+}
+
+static int is_word(const char *s, const char *end, const char *word) {
+    char next = char_at(s, end, strlen(word));
+    return starts_with(s, end, word) && !isalnum((unsigned char)next) && next != '_' && next != '.';
+}
+
+static int add_span(Compiler *c, NVXSpan s) { return add_str(c, s.start, s.len); }
+
+// a "..." literal is stored without its quotes and with \" turned into "
+static int add_literal(Compiler *c, NVXSpan s) {
+    s = nvx_span_unquote(s);
+    int at = add_str(c, s.start, s.len);
+    if (c->failed) return at;
+    char *d = c->prog->strs[at];
+    for (size_t i = 0; i < s.len; ++i) {
+        if (s.start[i] == '\\' && i + 1 < s.len && s.start[i+1] == '"') i++;
+        *d++ = s.start[i];
+    }
+    *d = '\0';
+    return at;
+}
+
+// 1 if s is exactly one "..." token
+static int is_string_literal(NVXSpan s) {
+    NVXLexer lx;
+    nvx_lex_init(&lx, s.start, s.len);
+    NVXLexToken t = nvx_lex_next(&lx);
+    return t.kind == LEX_STRING && t.len == s.len && t.len >= 2 && s.start[s.len-1] == '"';
+}
+
+// call operands may be quoted or bare
+static int add_operand(Compiler *c, NVXSpan s) {
+    return is_string_literal(s) ? add_literal(c, s) : add_span(c, s);
+}
+
+// the call a statement starts with (`nvx.http_get(...)`); LEX_END otherwise
+static NVXLexToken callee(NVXSpan s) {
+    NVXLexer lx;
+    nvx_lex_init(&lx, s.start, s.len);
+    NVXLexToken t = nvx_lex_next(&lx);
+    if (t.kind != LEX_IDENT || nvx_lex_next(&lx).kind != LEX_LPAREN) t.kind = LEX_END;
+    return t;
+}
+
+// the arguments of a call as up to max spans (missing ones are empty);
+// the last span keeps any further commas. Returns -1 if there is no '('.
+static int call_args(NVXSpan s, NVXSpan *out, int max) {
+    NVXSpan inner;
+    for (int i = 0; i < max; ++i) { out[i].start = s.start + s.len; out[i].len = 0; }
+    if (!nvx_lex_call_args(s.start, s.len, &inner)) return -1;
+    return nvx_lex_split_args(inner.start, inner.len, out, max);
+}
+
+// text after the first `=` of s, trimmed
+static NVXSpan after_eq(NVXSpan s) {
+    const char *eq = memchr(s.start, '=', s.len);
+    NVXSpan r = { s.start + s.len, 0 };
+    if (eq) { r.start = eq + 1; r.len = (size_t)(s.start + s.len - r.start); }
+    return nvx_span_trim(r);
+}
+
+// skip blanks, empty lines and comment lines; returns the cursor or NULL at end
+static const char *peek(Compiler *c) {
+    while (c->pos < c->len) {
+        char ch = c->src[c->pos];
+        if (ch == '\0') { c->pos++; continue; }
+        if (isspace((unsigned char)ch)) { c->pos++; continue; }
+        if (ch == '#') { c->pos = (size_t)(line_end(c, c->src + c->pos) - c->src); continue; }
+        return c->src + c->pos;
+    }
+    return NULL;
+}
+
+// the `{` on a header line, skipping braces inside strings; NULL if none
+static const char *header_brace(const Compiler *c, const char *header) {
+    NVXLexer lx;
+    nvx_lex_init(&lx, header, (size_t)(line_end(c, header) - header));
+    NVXLexToken t;
+    while ((t = nvx_lex_next(&lx)).kind != LEX_END) {
+        if (t.kind == LEX_LBRACE) return t.start;
+    }
+    return NULL;
+}
+
+// a block opener may sit on the header line or on the next line by itself;
+// returns its offset (len of the source if there is none)
+static size_t open_block(Compiler *c, const char *header) {
+    const char *brace = header_brace(c, header);
+    if (brace) { c->pos = (size_t)(brace + 1 - c->src); return (size_t)(brace - c->src); }
+    c->pos = (size_t)(line_end(c, header) - c->src);
+    const char *s = peek(c);
+    if (s && *s == '{') { c->pos++; return (size_t)(s - c->src); }
+    return c->len;
+}
+
+static void compile_block(Compiler *c, int nested);
+
+// user.input_*/user.choice_* calls and their short forms, see assign_input
+static const struct { const char *name; int mode; } input_calls[] = {
+    {"user.input_var", 1}, {"input_var", 1},
+    {"user.input_str", 2}, {"input_str", 2}, {"user.input", 2}, {"input", 2},
+    {"user.input_math", 3}, {"input_math", 3},
+    {"user.choice_var", 4}, {"choice_var", 4},
+    {"user.choice_str", 5}, {"choice_str", 5},
+};
+
+// math(expr) / math(NAME=expr): lhs is -1 for the first form
+static void compile_math(Compiler *c, int op, int lhs, NVXSpan value) {
+    NVXSpan expr;
+    if (!nvx_lex_call_args(value.start, value.len, &expr)) return;
+    const char *eq = memchr(expr.start, '=', expr.len);
+    if (eq) {
+        NVXSpan name = { expr.start, (size_t)(eq - expr.start) };
+        emit(c, OP_MATH, 0, add_span(c, nvx_span_trim(name)), add_span(c, after_eq(expr)), 0);
+    } else {
+        emit(c, op, 0, lhs, add_span(c, expr), 0);
+    }
+}
+
+// sys.spawn / sys.output / sys.wait / sys.wait_all; dst is -1 for the statement form
+static void compile_process(Compiler *c, int dst, NVXLexToken fn, NVXSpan call) {
+    NVXSpan arg[2];
+    call_args(call, arg, 2);
+    int second = arg[1].len ? add_operand(c, arg[1]) : -1;
+    if (nvx_lex_is(&fn, "sys.wait_all")) {
+        emit(c, OP_WAIT, 1, dst, 0, 0);
+    } else if (nvx_lex_is(&fn, "sys.wait")) {
+        if (!arg[0].len) { compile_error(c, "sys.wait needs a handle."); return; }
+        emit(c, OP_WAIT, 0, dst, add_operand(c, arg[0]), second);
+    } else if (nvx_lex_is(&fn, "sys.output") && dst < 0) {
+        compile_error(c, "sys.output must be assigned: NAME=sys.output(cmd).");
+    } else {
+        emit(c, OP_SPAWN, nvx_lex_is(&fn, "sys.output"), dst, add_operand(c, arg[0]), second);
+    }
+}
+
+// nvx.http_get_many(url, ...): every URL is a "..." literal or a variable holding one
+static void compile_http_many(Compiler *c, int dst, NVXSpan call) {
+    NVXProgram *p = c->prog;
+    NVXSpan args, arg[2];
+    nvx_lex_call_args(call.start, call.len, &args);
+    int first = p->arg_len, count = 0, n;
+    while ((n = nvx_lex_split_args(args.start, args.len, arg, 2)) > 0) {
+        int literal = is_string_literal(arg[0]);
+        if (!literal && !nvx_span_is_identifier(arg[0])) {
+            compile_error(c, "nvx.http_get_many takes quoted URLs or variable names.");
+            return;
+        }
+        if (!grow((void **)&p->args, &p->arg_cap, p->arg_len + 1, sizeof(NVXPrintArg))) { c->failed = 1; return; }
+        NVXPrintArg *pa = &p->args[p->arg_len++];
+        pa->kind = literal ? PRINT_LITERAL : PRINT_VAR;
+        pa->str = literal ? add_literal(c, arg[0]) : add_span(c, arg[0]);
+        count++;
+        if (n < 2) break;
+        args = arg[1];
+    }
+    if (!count) { compile_error(c, "nvx.http_get_many needs at least one URL."); return; }
+    emit(c, OP_HTTP_MANY, 0, dst, first, count);
+}
+
+static void compile_assignment(Compiler *c, NVXSpan name, NVXSpan value) {
+    int dst = add_span(c, name);
+    NVXLexToken fn = callee(value);
+    NVXSpan arg[2];
+    if (nvx_lex_is(&fn, "sys.command")) {
+        call_args(value, arg, 1);
+        emit(c, OP_SYS, 0, dst, add_operand(c, arg[0]), 0);
+        return;
+    }
+    if (nvx_lex_is(&fn, "sys.spawn") || nvx_lex_is(&fn, "sys.output") || nvx_lex_is(&fn, "sys.wait") || nvx_lex_is(&fn, "sys.wait_all")) {
+        compile_process(c, dst, fn, value);
+        return;
+    }
+    if (nvx_lex_is(&fn, "nvx.http_get") || nvx_lex_is(&fn, "nvx.http_post")) {
+        int is_post = nvx_lex_is(&fn, "nvx.http_post");
+        call_args(value, arg, 2);
+        emit(c, OP_HTTP, 0, dst, add_operand(c, arg[0]), is_post ? add_operand(c, arg[1]) : -1);
+        return;
+    }
+    if (nvx_lex_is(&fn, "nvx.http_get_many")) {
+        compile_http_many(c, dst, value);
+        return;
+    }
+    if (nvx_lex_is(&fn, "nvx.http_download") || nvx_lex_is(&fn, "nvx.http_json_get")) {
+        int download = nvx_lex_is(&fn, "nvx.http_download");
+        call_args(value, arg, 2);
+        emit(c, download ? OP_HTTP_DOWNLOAD : OP_HTTP_JSON, 0, dst, add_operand(c, arg[0]), add_operand(c, arg[1]));
+        return;
+    }
+    if (nvx_lex_is(&fn, "nvx.json_get")) {
+        call_args(value, arg, 2);
+        int literal = is_string_literal(arg[0]);
+        emit(c, OP_JSON_GET, literal, dst, add_operand(c, arg[0]), add_operand(c, arg[1]));
+        return;
+    }
+    for (size_t i = 0; fn.kind == LEX_IDENT && i < sizeof(input_calls) / sizeof(input_calls[0]); ++i) {
+        if (!nvx_lex_is(&fn, input_calls[i].name)) continue;
+        nvx_lex_call_args(value.start, value.len, &arg[0]);
+        emit(c, OP_INPUT, input_calls[i].mode, dst, add_span(c, arg[0]), 0);
+        return;
+    }
+    if (nvx_lex_is(&fn, "math.vars") || nvx_lex_is(&fn, "math")) {
+        compile_math(c, OP_SET_MATH, dst, value);
+        return;
+    }
+    if (is_string_literal(value)) {
+        emit(c, OP_SET_STR, 0, dst, add_literal(c, value), 0);
+        return;
+    }
+    emit(c, OP_SET_COPY, 0, dst, add_span(c, value), 0);
+}
+
+static void compile_print(Compiler *c, NVXSpan args) {
+    NVXProgram *p = c->prog;
+    int first = p->arg_len;
+    int count = 0;
+    NVXSpan arg[2];
+    int n;
+    while ((n = nvx_lex_split_args(args.start, args.len, arg, 2)) > 0) {
+        if (arg[0].len) {
+            if (!grow((void **)&p->args, &p->arg_cap, p->arg_len + 1, sizeof(NVXPrintArg))) { c->failed = 1; return; }
+            NVXPrintArg *pa = &p->args[p->arg_len++];
+            if (is_string_literal(arg[0])) {
+                pa->kind = PRINT_LITERAL;
+                pa->str = add_literal(c, arg[0]);
+            } else {
+                pa->kind = nvx_span_is_identifier(arg[0]) ? PRINT_VAR : PRINT_EXPR;
+                pa->str = add_span(c, arg[0]);
+            }
+            count++;
+        }
+        if (n < 2) break;
+        args = arg[1];
+    }
+    emit(c, OP_PRINT, 0, first, count, 0);
+}
+
+// NAME=value: a top-level `=` before any call parenthesis (math(x=1) is not one)
+static int split_assignment(NVXSpan s, NVXSpan *name, NVXSpan *value) {
+    NVXLexer lx;
+    nvx_lex_init(&lx, s.start, s.len);
+    NVXLexToken t;
+    while ((t = nvx_lex_next(&lx)).kind != LEX_END && t.kind != LEX_LPAREN) {
+        if (t.kind != LEX_OP || !nvx_lex_is(&t, "=")) continue;
+        name->start = s.start;
+        name->len = (size_t)(t.start - s.start);
+        *name = nvx_span_trim(*name);
+        value->start = t.start + 1;
+        value->len = (size_t)(s.start + s.len - value->start);
+        *value = nvx_span_trim(*value);
+        return 1;
+    }
+    return 0;
+}
+
+// statements are dispatched on their first token; s is trimmed and is not
+// NUL-terminated when it ends at a `}`
+static void compile_statement(Compiler *c, NVXSpan s) {
+    NVXLexer lx;
+    nvx_lex_init(&lx, s.start, s.len);
+    NVXLexToken first = nvx_lex_next(&lx);
+    NVXLexToken second = nvx_lex_next(&lx);
+    int alone = (first.len == s.len);
+    if (alone && nvx_lex_is(&first, "NevoidX.commands")) { emit(c, OP_HELP, 0, 0, 0, 0); return; }
+    if (alone && (nvx_lex_is(&first, "break") || nvx_lex_is(&first, "continue"))) {
+        LoopCtx *l = c->loop;
+        if (!l) { compile_error(c, "%.*s outside a loop.", (int)s.len, s.start); return; }
+        add_jump(c, s.start[0] == 'b' ? &l->breaks : &l->conts, emit(c, OP_JUMP, 0, 0, 0, 0));
+        return;
+    }
+    if (second.kind == LEX_OP && nvx_lex_is(&second, "=")) {
+        int type = nvx_lex_is(&first, "def.var") ? 1 : nvx_lex_is(&first, "def.str") ? 2 : nvx_lex_is(&first, "def.math") ? 3 : 0;
+        if (type) { emit(c, OP_DEF, 0, add_span(c, after_eq(s)), type, 0); return; }
+        if (nvx_lex_is(&first, "delay")) {
+            int delay_val = atoi(second.start + 1);
+            if (delay_val >= 0) emit(c, OP_DELAY, 0, delay_val, 0, 0);
+            return;
+        }
+    }
+    NVXSpan name, value;
+    if (split_assignment(s, &name, &value)) {
+        compile_assignment(c, name, value);
+        return;
+    }
+    if (first.kind != LEX_IDENT) return;
+    if (nvx_lex_is(&first, "goto")) {
+        NVXSpan target = { second.start, (size_t)(s.start + s.len - second.start) };
+        target = nvx_span_trim(target);
+        emit(c, OP_GOTO, 0, find_block(c, target.start, target.len), 0, 0);
+        return;
+    }
+    if (second.kind != LEX_LPAREN) return;
+    NVXSpan arg[3];
+    if (nvx_lex_is(&first, "math.map")) {
+        if (call_args(s, arg, 3) < 3) { compile_error(c, "math.map needs (expr, inputfile, outputfile)."); return; }
+        emit(c, OP_MATH_MAP, 0, add_operand(c, arg[0]), add_operand(c, arg[1]), add_operand(c, arg[2]));
+        return;
+    }
+    if (nvx_lex_is(&first, "math.vars") || nvx_lex_is(&first, "math")) {
+        compile_math(c, OP_MATH, -1, s);
+        return;
+    }
+    if (nvx_lex_is(&first, "print")) {
+        nvx_lex_call_args(s.start, s.len, &arg[0]);
+        compile_print(c, arg[0]);
+        return;
+    }
+    if (nvx_lex_is(&first, "sys.command")) {
+        call_args(s, arg, 1);
+        emit(c, OP_SYS, 0, -1, add_operand(c, arg[0]), 0);
+        return;
+    }
+    if (nvx_lex_is(&first, "sys.spawn") || nvx_lex_is(&first, "sys.output") || nvx_lex_is(&first, "sys.wait") || nvx_lex_is(&first, "sys.wait_all")) {
+        compile_process(c, -1, first, s);
+        return;
+    }
+    if (nvx_lex_is(&first, "nvx.http_get_many")) {
+        compile_error(c, "nvx.http_get_many must be assigned: NAME=nvx.http_get_many(url, ...).");
+        return;
+    }
+    if (nvx_lex_is(&first, "nvx.http_download")) {
+        if (call_args(s, arg, 2) < 2) { compile_error(c, "nvx.http_download needs (url, file)."); return; }
+        emit(c, OP_HTTP_DOWNLOAD, 0, -1, add_operand(c, arg[0]), add_operand(c, arg[1]));
+        return;
+    }
+    if (nvx_lex_is(&first, "nvx.route")) {
+        NVXSpan r[4];
+        if (call_args(s, r, 4) < 2 || !nvx_span_is_identifier(r[1])) {
+            compile_error(c, "nvx.route needs (path, block[, bodyvar, responsevar]).");
+            return;
+        }
+        int path = add_operand(c, r[0]), block = add_span(c, r[1]);
+        // the two variable names are added back to back: OP_ROUTE keeps only the first
+        int in = r[2].len ? add_span(c, r[2]) : add_cstr(c, "body");
+        if (r[3].len) add_span(c, r[3]);
+        else add_cstr(c, "response");
+        emit(c, OP_ROUTE, 0, path, block, in);
+        return;
+    }
+    if (nvx_lex_is(&first, "nvx.static")) {
+        if (call_args(s, arg, 2) < 2) { compile_error(c, "nvx.static needs (prefix, directory)."); return; }
+        emit(c, OP_STATIC, 0, add_operand(c, arg[0]), add_operand(c, arg[1]), 0);
+        return;
+    }
+    if (nvx_lex_is(&first, "nvx.serve")) {
+        if (call_args(s, arg, 1) < 1 || !arg[0].len) { compile_error(c, "nvx.serve needs a port."); return; }
+        emit(c, OP_SERVE, 0, add_operand(c, arg[0]), 0, 0);
+        return;
+    }
+}
+
+// text of a block header after its keyword (kwlen characters) up to `{` or
+// the end of the line; parentheses around all of it are removed. Returns a
+// malloc'd string.
+static char *header_text(Compiler *c, const char *header, size_t kwlen) {
+    const char *to = header_brace(c, header);
+    if (!to) to = line_end(c, header);
+    NVXSpan t = { header + kwlen, to > header + kwlen ? (size_t)(to - header - kwlen) : 0 };
+    t = nvx_span_trim(t);
+    if (nvx_span_is_group(t)) {
+        t.start++;
+        t.len -= 2;
+        t = nvx_span_trim(t);
+    }
+    char *text = nvx_span_dup(t);
+    if (!text) c->failed = 1;
+    return text;
+}
+
+// condition of an `if`/`else if`/`while` header, compiled once
+static int add_condition(Compiler *c, const char *header, size_t kwlen) {
+    char *cond = header_text(c, header, kwlen);
+    if (!cond) return 0;
+    NVXProgram *p = c->prog;
+    NVXCond *cc = nvx_cond_compile(p->ctx, cond);
+    free(cond);
+    if (!cc || !grow((void **)&p->conds, &p->cond_cap, p->cond_len + 1, sizeof(NVXCond *))) {
+        nvx_cond_free(cc); c->failed = 1; return 0;
+    }
+    p->conds[p->cond_len] = cc;
+    return p->cond_len++;
+}
+
+static void patch(Compiler *c, int at, int target) {
+    if (at < 0 || c->failed) return;
+    NVXInstr *in = &c->prog->code[at];
+    if (in->op == OP_JUMP) in->a = target;
+    else in->b = target;
+}
+
+// point every jump in l at target and release the list
+static void patch_jumps(Compiler *c, JumpList *l, int target) {
+    for (int i = 0; i < l->len; ++i) patch(c, l->at[i], target);
+    free(l->at);
+    *l = (JumpList){ NULL, 0, 0 };
+}
+
+// if (cond) { ... } else if (cond) { ... } else { ... }
+static void compile_if(Compiler *c, const char *header) {
+    JumpList ends = { NULL, 0, 0 };
+    int jf = emit(c, OP_JUMP_IF_NOT, 0, add_condition(c, header, 2), 0, 0);
+    open_block(c, header);
+    compile_block(c, 1);
+    const char *s, *e;
+    while ((s = peek(c)) && (e = line_end(c, s)) && (is_word(s, e, "else") || starts_with(s, e, "elseif"))) {
+        add_jump(c, &ends, emit(c, OP_JUMP, 0, 0, 0, 0));
+        patch(c, jf, c->prog->code_len);
+        jf = -1;
+        const char *t = s + 4;
+        while (t < e && isspace((unsigned char)*t)) t++;
+        if (starts_with(s, e, "elseif")) t = s + 4;
+        if (is_word(t, e, "if") || starts_with(t, e, "if(")) {
+            jf = emit(c, OP_JUMP_IF_NOT, 0, add_condition(c, t, 2), 0, 0);
+            open_block(c, t);
+            compile_block(c, 1);
+            continue;
+        }
+        open_block(c, s);
+        compile_block(c, 1);
+        break;
+    }
+    patch(c, jf, c->prog->code_len);
+    patch_jumps(c, &ends, c->prog->code_len);
+}
+
+// compile a loop body with its break/continue jumps collected in ctx
+static void compile_loop_body(Compiler *c, const char *header, LoopCtx *ctx) {
+    ctx->breaks = ctx->conts = (JumpList){ NULL, 0, 0 };
+    ctx->outer = c->loop;
+    c->loop = ctx;
+    open_block(c, header);
+    compile_block(c, 1);
+    c->loop = ctx->outer;
+}
+
+static void patch_loop(Compiler *c, LoopCtx *ctx, int cont, int exit) {
+    patch_jumps(c, &ctx->conts, cont);
+    patch_jumps(c, &ctx->breaks, exit);
+}
+
+static int add_loop(Compiler *c, int var, int start, int limit, int step) {
+    NVXProgram *p = c->prog;
+    if (!grow((void **)&p->loops, &p->loop_cap, p->loop_len + 1, sizeof(NVXLoop))) { c->failed = 1; return 0; }
+    NVXLoop *l = &p->loops[p->loop_len];
+    l->var = var; l->start = start; l->limit = limit; l->step = step;
+    return p->loop_len++;
+}
+
+// while COND { ... }
+static void compile_while(Compiler *c, const char *header) {
+    int top = c->prog->code_len;
+    int jf = emit(c, OP_JUMP_IF_NOT, 0, add_condition(c, header, 5), 0, 0);
+    LoopCtx ctx;
+    compile_loop_body(c, header, &ctx);
+    emit(c, OP_JUMP, 0, top, 0, 0);
+    patch(c, jf, c->prog->code_len);
+    patch_loop(c, &ctx, top, c->prog->code_len);
+}
+
+// repeat N { ... } and for VAR=START to LIMIT [step STEP] { ... }
+static void compile_counted(Compiler *c, const char *header, int is_for) {
+    char *text = header_text(c, header, is_for ? 3 : 6);
+    if (!text) return;
+    int loop;
+    if (is_for) {
+        char *eq = strchr(text, '=');
+        char *to = eq ? strstr(eq, " to ") : NULL;
+        if (!to) {
+            // malformed header: the body is compiled but never entered
+            compile_error(c, "for needs NAME=START to LIMIT [step STEP].");
+            free(text);
+            int skip = emit(c, OP_JUMP, 0, 0, 0, 0);
+            LoopCtx ctx;
+            compile_loop_body(c, header, &ctx);
+            patch(c, skip, c->prog->code_len);
+            patch_loop(c, &ctx, c->prog->code_len, c->prog->code_len);
+            return;
+        }
+        *eq = '\0'; *to = '\0';
+        char *limit = to + 4;
+        char *step = strstr(limit, " step ");
+        if (step) { *step = '\0'; step += 6; trim(step); }
+        trim(text); trim(eq + 1); trim(limit);
+        int var = nvx_var_slot(c->prog->ctx, text);
+        if (var < 0) { c->failed = 1; free(text); return; }
+        loop = add_loop(c, var, add_cstr(c, eq + 1), add_cstr(c, limit), step ? add_cstr(c, step) : -1);
+    } else {
+        loop = add_loop(c, -1, -1, add_cstr(c, text), -1);
+    }
+    free(text);
+    emit(c, OP_LOOP_INIT, 0, loop, 0, 0);
+    int top = emit(c, OP_LOOP_NEXT, 0, loop, 0, 0);
+    LoopCtx ctx;
+    compile_loop_body(c, header, &ctx);
+    int cont = is_for ? emit(c, OP_LOOP_STEP, 0, loop, 0, 0) : top;
+    emit(c, OP_JUMP, 0, top, 0, 0);
+    patch(c, top, c->prog->code_len);
+    patch_loop(c, &ctx, cont, c->prog->code_len);
+}
+
+// void name { ... }: the body is compiled in place and skipped over until a goto
+static void compile_void(Compiler *c, const char *header) {
+    const char *e = line_end(c, header), *name = header + 4;
+    while (name < e && isspace((unsigned char)*name)) name++;
+    size_t n = 0;
+    while (name + n < e && !isspace((unsigned char)name[n]) && name[n] != '{') n++;
+    int blk = find_block(c, name, n);
+    size_t open = open_block(c, header);
+    size_t body_start = c->pos, body_end = brace_close(c, open);
+    int at = emit(c, OP_BLOCK, 0, blk, 0, 0);
+    LoopCtx *outer = c->loop; // a block body is entered by goto, not part of an enclosing loop
+    c->loop = NULL;
+    compile_block(c, 1);
+    c->loop = outer;
+    emit(c, OP_RETURN, 0, 0, 0, 0);
+    if (!c->failed) {
+        c->prog->code[at].b = c->prog->code_len;
+        c->prog->code[at].c = add_str(c, c->src + body_start, body_end - body_start);
+    }
+}
+
+// statement text runs to the end of the line, or inside a block up to a closing brace
+static NVXSpan take_statement(Compiler *c, const char *s, int nested) {
+    const char *end = line_end(c, s);
+    if (nested) {
+        NVXLexer lx;
+        nvx_lex_init(&lx, s, (size_t)(end - s));
+        NVXLexToken t;
+        int depth = 0;
+        while ((t = nvx_lex_next(&lx)).kind != LEX_END) {
+            if (t.kind == LEX_LPAREN) depth++;
+            else if (t.kind == LEX_RPAREN) depth--;
+            else if (t.kind == LEX_RBRACE && depth <= 0) { end = t.start; break; }
+        }
+    }
+    c->pos = (size_t)(end - c->src);
+    NVXSpan stmt = { s, (size_t)(end - s) };
+    return nvx_span_trim(stmt);
+}
+
+static void compile_block(Compiler *c, int nested) {
+    const char *s;
+    while (!c->failed && (s = peek(c))) {
+        if (*s == '}') {
+            c->pos++;
+            if (nested) return;
+            continue;
+        }
+        const char *e = line_end(c, s);
+        if (starts_with(s, e, "void ") && header_brace(c, s)) { compile_void(c, s); continue; }
+        if (starts_with(s, e, "if ") || starts_with(s, e, "if(") || starts_with(s, e, "if\t")) { compile_if(c, s); continue; }
+        if (is_word(s, e, "while") && (isspace((unsigned char)char_at(s, e, 5)) || char_at(s, e, 5) == '(')) { compile_while(c, s); continue; }
+        if (is_word(s, e, "repeat") && (isspace((unsigned char)char_at(s, e, 6)) || char_at(s, e, 6) == '(')) { compile_counted(c, s, 0); continue; }
+        if (is_word(s, e, "for") && (isspace((unsigned char)char_at(s, e, 3)) || char_at(s, e, 3) == '(')) { compile_counted(c, s, 1); continue; }
+        if (is_word(s, e, "else")) {
+            // dangling else without a matching if: skip the line
+            c->pos = (size_t)(e - c->src);
+            continue;
+        }
+        NVXSpan stmt = take_statement(c, s, nested);
+        if (stmt.len) compile_statement(c, stmt);
+    }
+}
+
+// a goto whose continuation (following plain jumps) is a return has nothing
+// left to do after the block: mark it so the VM jumps instead of calling
+static void mark_tail_gotos(NVXProgram *p) {
+    for (int i = 0; i < p->code_len; ++i) {
+        if (p->code[i].op != OP_GOTO) continue;
+        int j = i + 1, hops = 0;
+        while (p->code[j].op == OP_JUMP && hops++ < p->code_len) j = p->code[j].a;
+        if (p->code[j].op == OP_RETURN) p->code[i].mode = 1;
+    }
+}
+
+NVXProgram *nvx_compile_source(NVXContext *ctx, const char *src, size_t len) {
+    int nlines = 1;
+    for (const char *q = src; (q = memchr(q, '\n', (size_t)(src + len - q))) != NULL; ++q) nlines++;
+    // the line index is scratch: compiling may happen in the middle of a run
+    // (a block definition), so release back to a mark
+    NVXArenaMark scratch = nvx_arena_mark(&ctx->arena);
+    NVXProgram *prog = nvx_calloc(1, sizeof(NVXProgram));
+    size_t *lines = nvx_arena_alloc(&ctx->arena, (size_t)nlines * sizeof(size_t));
+    if (!prog || !lines) { free(prog); nvx_arena_release(&ctx->arena, scratch); return NULL; }
+    prog->ctx = ctx;
+    nlines = 0;
+    lines[nlines++] = 0;
+    for (const char *q = src; (q = memchr(q, '\n', (size_t)(src + len - q))) != NULL; ) {
+        q++;
+        lines[nlines++] = (size_t)(q - src);
+    }
+    // the source is only read, in place: no copy, however large the script
+    Compiler c = { prog, src, len, 0, 0, NULL, lines, nlines, NULL, 0 };
+    if (match_braces(&c)) compile_block(&c, 0);
+    else c.failed = 1;
+    emit(&c, OP_RETURN, 0, 0, 0, 0);
+    nvx_arena_release(&ctx->arena, scratch);
+    free(c.braces);
+    if (c.failed) { nvx_program_free(prog); return NULL; }
+    mark_tail_gotos(prog);
+    return prog;
+}
+
+void nvx_program_free(NVXProgram *prog) {
+    if (!prog) return;
+    nvx_arena_destroy(&prog->strings);
+    free(prog->strs);
+    free(prog->code);
+    free(prog->args);
+    free(prog->blocks);
+    for (int i = 0; i < prog->cond_len; ++i) nvx_cond_free(prog->conds[i]);
+    free(prog->conds);
+    free(prog->loops);
+    free(prog);
+}
+
+// VM: one pass over the instruction array, each statement runs a handler
+// with operands that were parsed at compile time
+// per-activation state of the program's repeat/for loops
+typedef struct { long long count; double limit, step; } LoopState;
+
+static double loop_bound(NVXContext *ctx, const char *expr, double fallback) {
+    double v;
+    return nvx_evaluate_math(ctx, expr, &v) ? v : fallback;
+}
+
+static const char *vm_run(NVXProgram *p, int pc, LoopState *ls);
+
+// returns NULL at the end of the program, or the name of a block defined
+// elsewhere that a tail goto continues in
+static const char *vm_exec(NVXProgram *p, int pc) {
+    if (p->loop_len == 0) return vm_run(p, pc, NULL);
+    NVXArenaMark m = nvx_arena_mark(&p->ctx->arena);
+    LoopState *ls = nvx_arena_alloc(&p->ctx->arena, (size_t)p->loop_len * sizeof(LoopState));
+    if (!ls) return NULL;
+    const char *next = vm_run(p, pc, ls);
+    nvx_arena_release(&p->ctx->arena, m);
+    return next;
+}
+
+static const char *vm_run(NVXProgram *p, int pc, LoopState *ls) {
+    NVXContext *ctx = p->ctx;
+    char **S = p->strs;
+    for (;;) {
+        const NVXInstr *in = &p->code[pc++];
+        switch (in->op) {
+        case OP_RETURN:
+            return NULL;
+        case OP_HELP:
+            print_help(ctx);
+            break;
+        case OP_DEF:
+            declare_variables(ctx, S[in->a], in->b);
+            break;
+        case OP_DELAY:
+            ctx->delay = in->a;
+            break;
+        case OP_SET_STR:
+            nvx_set_variable(ctx, S[in->a], S[in->b]);
+            break;
+        case OP_SET_COPY:
+            assign_value(ctx, S[in->a], S[in->b]);
+            break;
+        case OP_SET_MATH:
+            assign_math(ctx, S[in->a], S[in->b]);
+            break;
+        case OP_MATH:
+            execute_math(ctx, in->a >= 0 ? S[in->a] : NULL, S[in->b]);
+            break;
+        case OP_MATH_MAP:
+            execute_math_map(ctx, S[in->a], S[in->b], S[in->c]);
+            break;
+        case OP_PRINT:
+            for (int i = 0; i < in->b; ++i) {
+                const NVXPrintArg *pa = &p->args[in->a + i];
+                if (pa->kind == PRINT_LITERAL) print_literal_arg(ctx, S[pa->str]);
+                else if (pa->kind == PRINT_VAR) print_var_arg(ctx, S[pa->str]);
+                else print_expr_arg(ctx, S[pa->str]);
+            }
+            printf("\n");
+            fflush(stdout);
+            break;
+        case OP_SYS:
+            assign_sys_command(ctx, in->a >= 0 ? S[in->a] : NULL, S[in->b]);
+            break;
+        case OP_SPAWN:
+            if (in->mode) assign_sys_output(ctx, S[in->a], S[in->b], in->c >= 0 ? S[in->c] : NULL);
+            else assign_spawn(ctx, in->a >= 0 ? S[in->a] : NULL, S[in->b], in->c >= 0 ? S[in->c] : NULL);
+            break;
+        case OP_WAIT:
+            if (in->mode) execute_wait_all(ctx, in->a >= 0 ? S[in->a] : NULL);
+            else execute_wait(ctx, in->a >= 0 ? S[in->a] : NULL, S[in->b], in->c >= 0 ? S[in->c] : NULL);
+            break;
+        case OP_HTTP:
+            assign_http(ctx, S[in->a], S[in->b], in->c >= 0 ? S[in->c] : NULL);
+            break;
+        case OP_HTTP_MANY: {
+            NVXArenaMark m = nvx_arena_mark(&ctx->arena);
+            const char **urls = nvx_arena_alloc(&ctx->arena, (size_t)in->c * sizeof(char *));
+            for (int i = 0; urls && i < in->c; ++i) {
+                const NVXPrintArg *pa = &p->args[in->b + i];
+                urls[i] = pa->kind == PRINT_LITERAL ? S[pa->str] : nvx_get_variable(ctx, S[pa->str]);
+            }
+            if (urls) assign_http_many(ctx, S[in->a], urls, in->c);
+            nvx_arena_release(&ctx->arena, m);
+            break;
+        }
+        case OP_HTTP_DOWNLOAD:
+            execute_http_download(ctx, in->a >= 0 ? S[in->a] : NULL, S[in->b], S[in->c]);
+            break;
+        case OP_HTTP_JSON:
+            assign_http_json(ctx, S[in->a], S[in->b], S[in->c]);
+            break;
+        case OP_JSON_GET:
+            assign_json_get(ctx, S[in->a], S[in->b], in->mode, S[in->c]);
+            break;
+        case OP_INPUT:
+            assign_input(ctx, S[in->a], in->mode, S[in->b]);
+            break;
+        case OP_ROUTE:
+            execute_route(ctx, S[in->a], S[in->b], S[in->c], S[in->c + 1]);
+            break;
+        case OP_STATIC:
+            execute_static(ctx, S[in->a], S[in->b]);
+            break;
+        case OP_SERVE:
+            execute_serve(ctx, S[in->a]);
+            break;
+        case OP_JUMP:
+            pc = in->a;
+            continue;
+        case OP_JUMP_IF_NOT:
+            if (!nvx_cond_eval(ctx, p->conds[in->a])) pc = in->b;
+            continue;
+        case OP_LOOP_INIT: {
+            const NVXLoop *l = &p->loops[in->a];
+            LoopState *st = &ls[in->a];
+            if (l->var < 0) {
+                st->count = (long long)loop_bound(ctx, S[l->limit], 0);
+            } else {
+                st->limit = loop_bound(ctx, S[l->limit], 0);
+                st->step = l->step >= 0 ? loop_bound(ctx, S[l->step], 1) : 1;
+                nvx_var_set_number(ctx, l->var, loop_bound(ctx, S[l->start], 0));
+            }
+            continue;
+        }
+        case OP_LOOP_NEXT: {
+            const NVXLoop *l = &p->loops[in->a];
+            LoopState *st = &ls[in->a];
+            if (l->var < 0) {
+                if (st->count-- <= 0) pc = in->b;
+                continue;
+            }
+            double v;
+            // the variable may have been changed by the body, as in C
+            if (!nvx_var_number(ctx, l->var, &v) || st->step == 0 ||
+                (st->step > 0 ? v > st->limit : v < st->limit)) pc = in->b;
+            continue;
+        }
+        case OP_LOOP_STEP: {
+            const NVXLoop *l = &p->loops[in->a];
+            double v;
+            if (nvx_var_number(ctx, l->var, &v)) nvx_var_set_number(ctx, l->var, v + ls[in->a].step);
+            continue;
+        }
+        case OP_BLOCK:
+            p->blocks[in->a].start = pc;
+            p->blocks[in->a].stored = store_named_block(ctx, S[p->blocks[in->a].name], S[in->c], p->blocks[in->a].stored);
+            pc = in->b;
+            continue;
+        case OP_GOTO: {
+            const NVXBlock *blk = &p->blocks[in->a];
+            if (in->mode) {
+                // tail position: the goto statement finishes here, then the block replaces it
+                do_delay(ctx);
+                if (blk->start < 0) return S[blk->name];
+                pc = blk->start;
+                continue;
+            }
+            if (blk->start >= 0) {
+                const char *next = vm_exec(p, blk->start);
+                if (next) execute_goto(ctx, next);
+            } else {
+                execute_goto(ctx, S[blk->name]);
+            }
+            break;
+        }
+        }
+        do_delay(ctx);
+    }
+}
+
+void nvx_program_run(NVXProgram *prog) {
+    NVXContext *ctx = prog->ctx; // prog itself may be freed when its run ends
+    while (prog) {
+        // a nested run (a block calling itself) keeps the outer run's definitions
+        if (!prog->running) {
+            for (int i = 0; i < prog->block_len; ++i) prog->blocks[i].start = -1;
+        }
+        prog->running++;
+        // the target name lives in prog's strings: resolve it before prog can go
+        const char *to = vm_exec(prog, 0);
+        NVXProgram *next = to ? find_named_block(ctx, to) : NULL;
+        if (to && !next) printf("NVD Error: Undefined label '%s'.\n", to);
+        if (--prog->running == 0 && prog->retired) nvx_program_free(prog);
+        prog = next;
+    }
+}
+
+void nvx_program_release(NVXProgram *prog) {
+    if (!prog) return;
+    if (prog->running) prog->retired = 1;
+    else nvx_program_free(prog);
+}
@@ -0,0 +1,89 @@
+#ifndef NVX_PROGRAM_H
+#define NVX_PROGRAM_H
+
+#include <stddef.h>
+#include "NVXArena.h"
+
+// compiled form of a script: the source is parsed once into a flat
+// instruction array which is then executed by a small dispatch loop.
+
+typedef struct NVXContext NVXContext;
+
+typedef enum {
+    OP_RETURN,      // end of program or named block body
+    OP_HELP,        // NevoidX.commands
+    OP_DEF,         // def.var/def.str/def.math: a=name list, b=type
+    OP_DELAY,       // delay=N: a=N
+    OP_SET_STR,     // NAME="literal": a=name, b=literal
+    OP_SET_COPY,    // NAME=value (variable copy or bare literal): a=name, b=value
+    OP_SET_MATH,    // NAME=math(expr): a=name, b=expr
+    OP_MATH,        // math(expr) or math(L=expr): a=lhs or -1, b=expr
+    OP_MATH_MAP,    // math.map(expr, infile, outfile): a=expr, b=infile, c=outfile
+    OP_PRINT,       // print(...): a=first arg, b=arg count
+    OP_SYS,         // [NAME=]sys.command(cmd): a=name or -1, b=cmd
+    OP_SPAWN,       // [NAME=]sys.spawn(cmd[,opts]) or, mode=1, NAME=sys.output(cmd[,opts]): a=name or -1, b=cmd, c=opts or -1
+    OP_WAIT,        // [NAME=]sys.wait(h[,OUT]): a=name or -1, b=handle, c=OUT or -1; mode=1 sys.wait_all()
+    OP_HTTP,        // NAME=nvx.http_get/post(url[,body]): a=name, b=url, c=body or -1
+    OP_HTTP_MANY,   // NAME=nvx.http_get_many(url,...): a=name, b=first arg, c=arg count
+    OP_HTTP_DOWNLOAD, // [NAME=]nvx.http_download(url,file): a=name or -1, b=url, c=file
+    OP_HTTP_JSON,   // NAME=nvx.http_json_get(url,key): a=name, b=url, c=key
+    OP_JSON_GET,    // NAME=nvx.json_get(json,key): a=name, b=json, c=key, mode=1 if json is literal
+    OP_INPUT,       // NAME=user.input_*/choice_*(...): a=name, b=raw args, mode=input mode
+    OP_ROUTE,       // nvx.route(path,block[,in,out]): a=path, b=block name, c=in (out is string c+1)
+    OP_STATIC,      // nvx.static(prefix,dir): a=prefix, b=dir
+    OP_SERVE,       // nvx.serve(port): a=port
+    OP_JUMP,        // a=target
+    OP_JUMP_IF_NOT, // a=condition, b=target
+    OP_LOOP_INIT,   // repeat/for entry, bounds evaluated once: a=loop
+    OP_LOOP_NEXT,   // next iteration or leave: a=loop, b=exit target
+    OP_LOOP_STEP,   // for: advance the loop variable: a=loop
+    OP_BLOCK,       // void NAME {: a=block, b=skip target, c=body text
+    OP_GOTO         // goto NAME: a=block, mode=1 in tail position (nothing runs after it)
+} NVXOpcode;
+
+typedef struct {
+    unsigned char op;
+    unsigned char mode;
+    int a, b, c;
+} NVXInstr;
+
+// print() and nvx.http_get_many() argument kinds, resolved at compile time
+enum { PRINT_LITERAL, PRINT_VAR, PRINT_EXPR };
+typedef struct { int kind; int str; } NVXPrintArg;
+
+// stored: named block version this program last stored (0 = not yet)
+typedef struct { int name; int start; unsigned stored; } NVXBlock;
+
+// `repeat N` (var = -1) or `for VAR=START to LIMIT [step STEP]`: slot of the
+// loop variable and string indices of the bound expressions (-1 = absent)
+typedef struct { int var; int start, limit, step; } NVXLoop;
+
+typedef struct NVXProgram {
+    NVXContext *ctx; // variable slots and named blocks refer to this context
+    NVXInstr *code; int code_len, code_cap;
+    char **strs; int str_len, str_cap; // string pool, the text lives in `strings`
+    NVXArena strings;
+    NVXPrintArg *args; int arg_len, arg_cap;
+    NVXBlock *blocks; int block_len, block_cap;
+    struct NVXCond **conds; int cond_len, cond_cap;
+    NVXLoop *loops; int loop_len, loop_cap;
+    int running;  // active nvx_program_run calls
+    int retired;  // replaced while running: freed when the last run ends
+} NVXProgram;
+
+// parse script source into a program for ctx; returns NULL on allocation failure.
+// The len bytes at src are read in place and need not be NUL-terminated.
+NVXProgram *nvx_compile_source(NVXContext *ctx, const char *src, size_t len);
+
+// execute a compiled program, in its context, from its first instruction. A `goto` in tail
+// position jumps instead of nesting a call; one that leaves the program for a
+// block stored by another program continues there in the same loop, so
+// `void loop { ... goto loop }` runs at constant stack depth.
+void nvx_program_run(NVXProgram *prog);
+
+void nvx_program_free(NVXProgram *prog);
+
+// free now, or once the program's current runs have finished
+void nvx_program_release(NVXProgram *prog);
+
+#endif // NVX_PROGRAM_H
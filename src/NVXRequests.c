@@ -2,58 +2,337 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <ctype.h>
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#define strncasecmp _strnicmp
 #else
+#include <strings.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <unistd.h>
+#include <pthread.h>
 #endif
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#endif
+
+// Requests are sent as HTTP/1.1 over pooled keep-alive connections. Resolved
+// addresses are cached per host:port for dns_ttl seconds, and idle sockets
+// are kept per host:port so a script polling one API reuses a single
+// connection instead of resolving and connecting every time.
+
+#define DNS_CACHE_SIZE 16
+#define DNS_MAX_ADDRS 4
+#define POOL_SIZE 16
+#define POOL_IDLE_SECONDS 4 // below the default idle timeout of NVX servers
+
+// resolved addresses, copied by value so they can be used without a lock
+typedef struct {
+    struct sockaddr_storage addr[DNS_MAX_ADDRS];
+    socklen_t len[DNS_MAX_ADDRS];
+    int n;
+} AddrList;
+
+typedef struct {
+    char key[280]; // "host:port"
+    AddrList addrs; // n == 0: free slot
+    time_t expires;
+} DnsEntry;
+
+typedef struct {
+    char key[280];
+    int fd; // -1 = free
+    time_t last_used;
+} PooledConn;
+
+static DnsEntry dns_cache[DNS_CACHE_SIZE];
+static PooledConn pool[POOL_SIZE];
+static int pool_ready = 0;
+static int dns_ttl = 60;
+
+#ifdef _WIN32
+// the Windows build is single threaded
+#define client_lock()
+#define client_unlock()
+#else
+static pthread_mutex_t client_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define client_lock() pthread_mutex_lock(&client_mutex)
+#define client_unlock() pthread_mutex_unlock(&client_mutex)
+#endif
+
+void nvx_http_set_dns_ttl(int seconds) {
+    client_lock();
+    dns_ttl = seconds > 0 ? seconds : 0;
+    client_unlock();
+}
+
+// client sockets are close-on-exec: a spawned child must not keep a pooled
+// connection open
+#ifndef SOCK_CLOEXEC
+#define SOCK_CLOEXEC 0
+#endif
+
+static void close_socket(int s) {
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
 
-static int socket_connect(const char *host, const char *port) {
-    struct addrinfo hints, *res, *rp;
+static void client_init(void) {
+    if (pool_ready) return;
+#ifdef _WIN32
+    // started once and left running: pooled sockets outlive a single request
+    WSADATA wsa;
+    WSAStartup(MAKEWORD(2,2), &wsa);
+#endif
+    for (int i = 0; i < POOL_SIZE; ++i) pool[i].fd = -1;
+    pool_ready = 1;
+}
+
+// resolve host:port into out, serving repeated lookups from the cache;
+// returns the number of addresses. Only the cache lookup and update hold
+// client_lock: a slow DNS query must not stall the other threads' requests.
+static int resolve(const char *key, const char *host, const char *port, AddrList *out) {
+    time_t now = time(NULL);
+    out->n = 0;
+    client_lock();
+    for (int i = 0; i < DNS_CACHE_SIZE; ++i) {
+        DnsEntry *e = &dns_cache[i];
+        if (e->addrs.n && now < e->expires && strcmp(e->key, key) == 0) { *out = e->addrs; break; }
+    }
+    client_unlock();
+    if (out->n) return out->n;
+    struct addrinfo hints, *res;
     memset(&hints, 0, sizeof(hints));
     hints.ai_family = AF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
-    int err = getaddrinfo(host, port, &hints, &res);
-    if (err != 0) return -1;
+    if (getaddrinfo(host, port, &hints, &res) != 0) return 0;
+    for (struct addrinfo *rp = res; rp && out->n < DNS_MAX_ADDRS; rp = rp->ai_next) {
+        if (rp->ai_addrlen > sizeof(out->addr[0])) continue;
+        memcpy(&out->addr[out->n], rp->ai_addr, rp->ai_addrlen);
+        out->len[out->n++] = (socklen_t)rp->ai_addrlen;
+    }
+    freeaddrinfo(res);
+    if (!out->n) return 0;
+    client_lock();
+    DnsEntry *slot = &dns_cache[0];
+    for (int i = 0; i < DNS_CACHE_SIZE; ++i) {
+        DnsEntry *e = &dns_cache[i];
+        if (e->addrs.n && strcmp(e->key, key) == 0) { slot = e; break; }
+        if (!e->addrs.n) slot = e;
+        else if (slot->addrs.n && e->expires < slot->expires) slot = e; // evict the oldest
+    }
+    strcpy(slot->key, key);
+    slot->addrs = *out;
+    slot->expires = now + dns_ttl;
+    client_unlock();
+    return out->n;
+}
+
+// blocking connect to the first address that accepts; no lock is held, so an
+// unreachable host only delays its own request
+static int socket_connect(const char *key, const char *host, const char *port) {
+    AddrList a;
     int s = -1;
-    for (rp = res; rp != NULL; rp = rp->ai_next) {
-        s = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+    for (int i = 0, n = resolve(key, host, port, &a); i < n; ++i) {
+        s = socket(a.addr[i].ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
         if (s == -1) continue;
-        if (connect(s, rp->ai_addr, rp->ai_addrlen) == 0) break;
-#ifdef _WIN32
-        closesocket(s);
-#else
-        close(s);
-#endif
+        if (connect(s, (struct sockaddr *)&a.addr[i], a.len[i]) == 0) break;
+        close_socket(s);
         s = -1;
     }
-    freeaddrinfo(res);
+    if (s >= 0) {
+        int on = 1; // requests are written in one piece; don't hold back the tail
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (char*)&on, sizeof(on));
+    }
     return s;
 }
 
+// take an idle connection to key from the pool, or -1
+static int pool_take(const char *key) {
+    int fd = -1;
+    time_t now = time(NULL);
+    client_lock();
+    for (int i = 0; i < POOL_SIZE && fd < 0; ++i) {
+        if (pool[i].fd < 0 || strcmp(pool[i].key, key) != 0) continue;
+        int s = pool[i].fd;
+        pool[i].fd = -1;
+        if (now - pool[i].last_used >= POOL_IDLE_SECONDS) { close_socket(s); continue; }
+#ifndef _WIN32
+        // a readable idle socket means the server closed it (or sent junk)
+        char probe;
+        if (recv(s, &probe, 1, MSG_PEEK | MSG_DONTWAIT) >= 0) { close_socket(s); continue; }
+#endif
+        fd = s;
+    }
+    client_unlock();
+    return fd;
+}
+
+// return a connection to the pool, replacing the least recently used one if full
+static void pool_put(const char *key, int fd) {
+    client_lock();
+    PooledConn *slot = &pool[0];
+    for (int i = 0; i < POOL_SIZE; ++i) {
+        if (pool[i].fd < 0) { slot = &pool[i]; break; }
+        if (pool[i].last_used < slot->last_used) slot = &pool[i];
+    }
+    if (slot->fd >= 0) close_socket(slot->fd);
+    strcpy(slot->key, key);
+    slot->fd = fd;
+    slot->last_used = time(NULL);
+    client_unlock();
+}
+
 static int sendall(int sock, const char *buf, int len) {
     int total = 0;
     while (total < len) {
+#ifdef MSG_NOSIGNAL
+        int sent = send(sock, buf + total, len - total, MSG_NOSIGNAL);
+#else
         int sent = send(sock, buf + total, len - total, 0);
+#endif
         if (sent <= 0) return -1;
         total += sent;
     }
     return 0;
 }
 
-static int recvall(int sock, char *buf, int bufsize) {
-    int total = 0;
-    int r;
-    while ((r = recv(sock, buf + total, bufsize - total - 1, 0)) > 0) {
-        total += r;
-        if (total >= bufsize-1) break;
+// buffered reader over a socket for parsing the response framing
+typedef struct {
+    int fd;
+    char buf[8192];
+    size_t pos, len;
+    int eof;
+} Reader;
+
+static int reader_fill(Reader *r) {
+    if (r->pos < r->len) return 1;
+    int n = recv(r->fd, r->buf, sizeof(r->buf), 0);
+    if (n <= 0) { r->eof = 1; return 0; }
+    r->pos = 0;
+    r->len = (size_t)n;
+    return 1;
+}
+
+// read one CRLF-terminated line (without the line ending); -1 on EOF
+static int read_line(Reader *r, char *line, size_t size) {
+    size_t n = 0;
+    for (;;) {
+        if (!reader_fill(r)) return -1;
+        char c = r->buf[r->pos++];
+        if (c == '\n') break;
+        if (c != '\r' && n + 1 < size) line[n++] = c;
+    }
+    line[n] = '\0';
+    return (int)n;
+}
+
+// body bytes are handed to the caller's sink straight from the read buffer
+typedef struct {
+    nvx_http_sink sink;
+    void *ctx;
+    long long total;
+} Body;
+
+// deliver exactly n body bytes (or until EOF when n is (size_t)-1);
+// returns 1 if the sink asked to stop
+static int read_body(Reader *r, Body *b, size_t n) {
+    while (n > 0) {
+        if (!reader_fill(r)) return n == (size_t)-1 ? 0 : -1;
+        size_t avail = r->len - r->pos;
+        size_t take = avail < n ? avail : n;
+        const char *data = r->buf + r->pos;
+        r->pos += take;
+        b->total += (long long)take;
+        if (n != (size_t)-1) n -= take;
+        if (b->sink && b->sink(data, take, b->ctx) != 0) return 1;
+    }
+    return 0;
+}
+
+static int read_chunked(Reader *r, Body *b) {
+    char line[256];
+    for (;;) {
+        if (read_line(r, line, sizeof(line)) < 0) return -1;
+        char *end;
+        unsigned long size = strtoul(line, &end, 16);
+        if (end == line) return -1;
+        if (size == 0) break;
+        if (size > 0x7fffffff) return -1;
+        int rc = read_body(r, b, size);
+        if (rc != 0) return rc;
+        if (read_line(r, line, sizeof(line)) != 0) return -1; // CRLF after the chunk
+    }
+    // trailers, up to the empty line
+    int n;
+    while ((n = read_line(r, line, sizeof(line))) > 0) { }
+    return n < 0 ? -1 : 0;
+}
+
+// 1xx, 204 and 304 responses and every reply to HEAD end with their head,
+// whatever Content-Length says; anything else without a length or chunked
+// encoding is delimited by close
+static int response_has_body(int status, int head) {
+    return !head && status >= 200 && status != 204 && status != 304;
+}
+
+// status code from a status line, 0 if there is none
+static int status_code(const char *line, size_t n) {
+    const char *sp = memchr(line, ' ', n);
+    if (!sp || (size_t)(sp - line) + 4 > n) return 0;
+    int code = 0;
+    for (int i = 1; i <= 3; ++i) {
+        if (!isdigit((unsigned char)sp[i])) return 0;
+        code = code * 10 + (sp[i] - '0');
     }
-    if (total >= 0) buf[total] = '\0';
-    return total;
+    return code;
+}
+
+// read one response; returns -1 on a broken or truncated response, 1 if the
+// sink stopped the transfer, otherwise 0 and *reusable tells whether the
+// connection can carry another request. Interim 1xx responses are skipped.
+static int read_response(Reader *r, Body *b, int head, int *reusable) {
+    char line[1024];
+    int keep, chunked, status, n;
+    long long length;
+    do {
+        keep = chunked = 0;
+        length = -1;
+        if ((n = read_line(r, line, sizeof(line))) < 0) return -1;
+        if (strncmp(line, "HTTP/1.1", 8) == 0) keep = 1;
+        else if (strncmp(line, "HTTP/", 5) != 0) return -1;
+        status = status_code(line, (size_t)n);
+        while ((n = read_line(r, line, sizeof(line))) > 0) {
+            if (strncasecmp(line, "Content-Length:", 15) == 0) length = atoll(line + 15);
+            else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0 && strstr(line + 18, "chunked")) chunked = 1;
+            else if (strncasecmp(line, "Connection:", 11) == 0) {
+                const char *v = line + 11;
+                while (*v == ' ') v++;
+                if (strncasecmp(v, "close", 5) == 0) keep = 0;
+                else if (strncasecmp(v, "keep-alive", 10) == 0) keep = 1;
+            }
+        }
+        if (n < 0) return -1;
+    } while (status >= 100 && status < 200 && status != 101);
+    int rc;
+    if (status == 101) { rc = 0; keep = 0; } // the connection now speaks another protocol
+    else if (!response_has_body(status, head)) rc = 0;
+    else if (chunked) rc = read_chunked(r, b);
+    else if (length >= 0) rc = read_body(r, b, (size_t)length);
+    else { rc = read_body(r, b, (size_t)-1); keep = 0; } // delimited by close
+    *reusable = rc == 0 && keep && r->pos == r->len;
+    return rc;
 }
 
 static void parse_url(const char *url, char *host, size_t hostsz, char *port, size_t portsz, char *path, size_t pathsz) {
@@ -65,69 +344,93 @@ static void parse_url(const char *url, char *host, size_t hostsz, char *port, si
     const char *colon = memchr(p, ':', hostlen);
     if (colon) {
         size_t hlen = (size_t)(colon - p);
+        if (hlen >= hostsz) hlen = hostsz - 1;
         strncpy(host, p, hlen); host[hlen] = '\0';
-        size_t plen = hostlen - hlen - 1;
+        size_t plen = hostlen - (size_t)(colon - p) - 1;
+        if (plen >= portsz) plen = portsz - 1;
         strncpy(port, colon+1, plen); port[plen] = '\0';
     } else {
+        if (hostlen >= hostsz) hostlen = hostsz - 1;
         strncpy(host, p, hostlen); host[hostlen] = '\0';
         strcpy(port, "80");
     }
-    if (slash) strncpy(path, slash, pathsz-1);
+    if (slash) { strncpy(path, slash, pathsz-1); path[pathsz-1] = '\0'; }
     else strcpy(path, "/");
 }
 
-static int http_request(const char *method, const char *url, const char *body, char *response, size_t resp_size) {
-#ifdef _WIN32
-    WSADATA wsa;
-    WSAStartup(MAKEWORD(2,2), &wsa);
-#endif
-    char host[256], port[16], path[1024];
+long long nvx_http_stream(const char *method, const char *url, const char *body, nvx_http_sink sink, void *ctx) {
+    char host[256], port[16], path[1024], key[280];
     parse_url(url, host, sizeof(host), port, sizeof(port), path, sizeof(path));
-    int s = socket_connect(host, port);
-    if (s < 0) return -1;
+    snprintf(key, sizeof(key), "%s:%s", host, port);
     char req[4096];
+    size_t body_len = body ? strlen(body) : 0;
+    int len;
     if (body) {
-        snprintf(req, sizeof(req), "%s %s HTTP/1.0\r\nHost: %s\r\nContent-Length: %zu\r\n\r\n%s", method, path, host, strlen(body), body);
+        len = snprintf(req, sizeof(req), "%s %s HTTP/1.1\r\nHost: %s\r\nContent-Length: %zu\r\n\r\n", method, path, host, body_len);
     } else {
-        snprintf(req, sizeof(req), "%s %s HTTP/1.0\r\nHost: %s\r\n\r\n", method, path, host);
+        len = snprintf(req, sizeof(req), "%s %s HTTP/1.1\r\nHost: %s\r\n\r\n", method, path, host);
     }
-    if (sendall(s, req, strlen(req)) < 0) {
-#ifdef _WIN32
-        closesocket(s);
-        WSACleanup();
-#else
-        close(s);
-#endif
-        return -1;
+    if (len < 0 || len >= (int)sizeof(req)) return -1;
+    // small bodies ride in the header packet
+    int inline_body = body && body_len < sizeof(req) - (size_t)len;
+    if (inline_body) {
+        memcpy(req + len, body, body_len);
+        len += (int)body_len;
     }
-    // receive and strip headers
-    char buf[8192];
-    int r = recvall(s, buf, sizeof(buf));
-    if (r < 0) {
-#ifdef _WIN32
-        closesocket(s);
-        WSACleanup();
-#else
-        close(s);
-#endif
-        return -1;
+    client_lock();
+    client_init();
+    client_unlock();
+
+    Reader rd;
+    // a pooled connection may have been closed by the server while idle;
+    // if it fails before any response byte arrives, retry on a fresh one
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        int reused = 0;
+        int s = attempt == 0 ? pool_take(key) : -1;
+        if (s >= 0) reused = 1;
+        else s = socket_connect(key, host, port);
+        if (s < 0) break;
+        Body b = { sink, ctx, 0 };
+        int reusable = 0;
+        rd.fd = s;
+        rd.pos = rd.len = 0;
+        rd.eof = 0;
+        int rc = sendall(s, req, len);
+        if (rc == 0 && body && !inline_body) rc = sendall(s, body, (int)body_len);
+        if (rc == 0) rc = read_response(&rd, &b, strcmp(method, "HEAD") == 0, &reusable);
+        if (rc < 0) {
+            close_socket(s);
+            if (reused && rd.len == 0) continue;
+            break;
+        }
+        if (reusable) pool_put(key, s);
+        else close_socket(s);
+        return b.total;
     }
+    return -1;
+}
+
+// fixed buffer sink: keeps the first size-1 bytes and drops the rest, but
+// keeps reading so the connection stays reusable
+typedef struct { char *out; size_t size, stored; } FixedBuf;
 
-    // find double CRLF
-    char *bodystart = strstr(buf, "\r\n\r\n");
-    if (bodystart) bodystart += 4;
-    else bodystart = buf;
-    if (response && resp_size > 0) {
-        strncpy(response, bodystart, resp_size-1);
-        response[resp_size-1] = '\0';
+static int fixed_sink(const char *data, size_t n, void *ctx) {
+    FixedBuf *f = ctx;
+    if (f->stored + 1 < f->size) {
+        size_t room = f->size - 1 - f->stored;
+        size_t take = n < room ? n : room;
+        memcpy(f->out + f->stored, data, take);
+        f->stored += take;
     }
-#ifdef _WIN32
-    closesocket(s);
-    WSACleanup();
-#else
-    close(s);
-#endif
-    return (int)strlen(bodystart);
+    return 0;
+}
+
+static int http_request(const char *method, const char *url, const char *body, char *response, size_t resp_size) {
+    FixedBuf f = { response, response ? resp_size : 0, 0 };
+    long long n = nvx_http_stream(method, url, body, fixed_sink, &f);
+    if (response && resp_size > 0) response[f.stored] = '\0';
+    if (n < 0) return -1;
+    return n > 0x7fffffff ? 0x7fffffff : (int)n;
 }
 
 int nvx_http_get(const char *url, char *response, size_t resp_size) {
@@ -137,3 +440,384 @@ int nvx_http_get(const char *url, char *response, size_t resp_size) {
 int nvx_http_post(const char *url, const char *body, char *response, size_t resp_size) {
     return http_request("POST", url, body, response, resp_size);
 }
+
+typedef struct { char *data; size_t len, cap; int failed; } GrowBuf;
+
+static int grow_sink(const char *data, size_t n, void *ctx) {
+    GrowBuf *g = ctx;
+    if (g->len + n + 1 > g->cap) {
+        size_t ncap = g->cap ? g->cap : 4096;
+        while (ncap < g->len + n + 1) ncap *= 2;
+        char *nb = realloc(g->data, ncap);
+        if (!nb) { g->failed = 1; return 1; }
+        g->data = nb;
+        g->cap = ncap;
+    }
+    memcpy(g->data + g->len, data, n);
+    g->len += n;
+    return 0;
+}
+
+char *nvx_http_fetch(const char *method, const char *url, const char *body, size_t *out_len) {
+    GrowBuf g = { NULL, 0, 0, 0 };
+    if (nvx_http_stream(method, url, body, grow_sink, &g) < 0 || g.failed) {
+        free(g.data);
+        return NULL;
+    }
+    if (!g.data) g.data = malloc(1);
+    if (!g.data) return NULL;
+    g.data[g.len] = '\0';
+    if (out_len) *out_len = g.len;
+    return g.data;
+}
+
+#ifdef __linux__
+
+// Fan-out: each request is a small state machine over a non-blocking socket
+// and one epoll loop moves all of them along. A response is collected whole
+// and its framing is checked after every read; the body is cut out of it
+// once the message is complete.
+enum { FETCH_QUEUED, FETCH_CONNECTING, FETCH_SENDING, FETCH_READING, FETCH_DONE, FETCH_FAILED };
+
+#define FETCH_DEFAULT_PARALLEL 8
+
+typedef struct {
+    char key[280], host[256], port[16];
+    char req[1400]; int req_len, sent;
+    int fd, reused, state;
+    AddrList addrs;
+    int next_addr;
+    GrowBuf in;          // the response as received, head included
+    size_t head_len;     // 0 until the head is complete
+    size_t scan;         // parse position: head lines, then chunk framing
+    long long length;    // Content-Length, -1 if absent
+    int status, chunked, keep, trailers;
+    size_t end;          // end of the message once complete
+    long long deadline;  // CLOCK_MONOTONIC ms, 0 = none
+} Fetch;
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int fetch_watch(int ep, Fetch *f, int op, unsigned events) {
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.ptr = f;
+    return epoll_ctl(ep, op, f->fd, &ev);
+}
+
+static void fetch_close(Fetch *f) {
+    if (f->fd >= 0) close(f->fd); // also leaves the epoll set
+    f->fd = -1;
+}
+
+// connect to the next address that accepts a socket; completion is reported
+// by EPOLLOUT
+static int fetch_connect(Fetch *f, int ep) {
+    while (f->next_addr < f->addrs.n) {
+        int i = f->next_addr++;
+        int s = socket(f->addrs.addr[i].ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (s < 0) continue;
+        int on = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (char*)&on, sizeof(on));
+        if (connect(s, (struct sockaddr *)&f->addrs.addr[i], f->addrs.len[i]) == 0 || errno == EINPROGRESS) {
+            f->fd = s;
+            f->state = FETCH_CONNECTING;
+            if (fetch_watch(ep, f, EPOLL_CTL_ADD, EPOLLOUT) == 0) return 1;
+            f->fd = -1;
+        }
+        close(s);
+    }
+    return 0;
+}
+
+// start on a fresh connection to the addresses resolved before the loop
+static int fetch_connect_fresh(Fetch *f, int ep) {
+    f->reused = 0;
+    f->next_addr = 0;
+    return fetch_connect(f, ep);
+}
+
+static int fetch_start(Fetch *f, int ep) {
+    int s = pool_take(f->key);
+    if (s >= 0) {
+        fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK);
+        f->fd = s;
+        f->reused = 1;
+        f->state = FETCH_SENDING;
+        if (fetch_watch(ep, f, EPOLL_CTL_ADD, EPOLLOUT) == 0) return 1;
+        fetch_close(f);
+    }
+    return fetch_connect_fresh(f, ep);
+}
+
+// a pooled connection that fails before any response byte was probably
+// closed by the server while idle: retry once on a fresh one
+static void fetch_error(Fetch *f, int ep) {
+    int retry = f->reused && f->in.len == 0;
+    fetch_close(f);
+    f->sent = 0;
+    if (!retry || !fetch_connect_fresh(f, ep)) f->state = FETCH_FAILED;
+}
+
+// case-insensitive search for word in the n bytes at s
+static int has_word(const char *s, size_t n, const char *word) {
+    size_t w = strlen(word);
+    for (size_t i = 0; i + w <= n; ++i) {
+        if (strncasecmp(s + i, word, w) == 0) return 1;
+    }
+    return 0;
+}
+
+// one head line (without its line ending); -1 if the status line is not HTTP
+static int fetch_head_line(Fetch *f, const char *line, size_t n, int first) {
+    if (first) {
+        if (n >= 8 && strncmp(line, "HTTP/1.1", 8) == 0) f->keep = 1;
+        else if (n < 5 || strncmp(line, "HTTP/", 5) != 0) return -1;
+        f->status = status_code(line, n);
+    } else if (n > 15 && strncasecmp(line, "Content-Length:", 15) == 0) {
+        f->length = atoll(line + 15);
+    } else if (n > 18 && strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+        if (has_word(line + 18, n - 18, "chunked")) f->chunked = 1;
+    } else if (n > 11 && strncasecmp(line, "Connection:", 11) == 0) {
+        if (has_word(line + 11, n - 11, "close")) f->keep = 0;
+        else if (has_word(line + 11, n - 11, "keep-alive")) f->keep = 1;
+    }
+    return 0;
+}
+
+// 1 once the response in f->in is complete, 0 if more is needed, -1 if it is
+// malformed or cut short by eof
+static int fetch_parse(Fetch *f, int eof) {
+    GrowBuf *g = &f->in;
+    char *nl;
+    while (!f->head_len) {
+        if (!g->len || !(nl = memchr(g->data + f->scan, '\n', g->len - f->scan))) return eof ? -1 : 0;
+        size_t start = f->scan, n = (size_t)(nl - g->data) - start;
+        f->scan = (size_t)(nl - g->data) + 1;
+        if (n && g->data[start + n - 1] == '\r') n--;
+        if (n == 0 && start > 0) f->head_len = f->scan;
+        else if (fetch_head_line(f, g->data + start, n, start == 0) < 0) return -1;
+        if (f->head_len && f->status >= 100 && f->status < 200 && f->status != 101) {
+            // interim response: drop it and parse the final one
+            g->len -= f->head_len;
+            memmove(g->data, g->data + f->head_len, g->len);
+            f->head_len = f->scan = 0;
+            f->length = -1;
+            f->status = f->chunked = f->keep = 0;
+        }
+    }
+    if (!response_has_body(f->status, 0)) {
+        if (f->status == 101) f->keep = 0; // the connection now speaks another protocol
+        f->end = f->head_len;
+        return 1;
+    }
+    if (f->chunked) {
+        for (;;) {
+            if (!(nl = memchr(g->data + f->scan, '\n', g->len - f->scan))) return eof ? -1 : 0;
+            size_t line_end = (size_t)(nl - g->data) + 1;
+            if (f->trailers) {
+                int empty = line_end - f->scan <= 2;
+                f->scan = line_end;
+                if (empty) { f->end = line_end; return 1; }
+                continue;
+            }
+            char *end;
+            unsigned long size = strtoul(g->data + f->scan, &end, 16);
+            if (end == g->data + f->scan || size > 0x7fffffff) return -1;
+            if (size == 0) { f->scan = line_end; f->trailers = 1; continue; }
+            if (g->len < line_end + size + 2) return eof ? -1 : 0; // data and its CRLF
+            f->scan = line_end + size + 2;
+        }
+    }
+    if (f->length >= 0) {
+        if (g->len - f->head_len >= (size_t)f->length) { f->end = f->head_len + (size_t)f->length; return 1; }
+        return eof ? -1 : 0;
+    }
+    if (!eof) return 0; // delimited by close
+    f->keep = 0;
+    f->end = g->len;
+    return 1;
+}
+
+// move the body to the start of the buffer (decoding chunks) and hand it out
+static char *fetch_body(Fetch *f, size_t *len) {
+    GrowBuf *g = &f->in;
+    size_t w = 0;
+    if (f->chunked) {
+        size_t r = f->head_len;
+        for (;;) {
+            char *nl = memchr(g->data + r, '\n', f->end - r);
+            unsigned long size = strtoul(g->data + r, NULL, 16);
+            r = (size_t)(nl - g->data) + 1;
+            if (size == 0) break;
+            memmove(g->data + w, g->data + r, size);
+            w += size;
+            r += size + 2;
+        }
+    } else {
+        w = f->end - f->head_len;
+        memmove(g->data, g->data + f->head_len, w);
+    }
+    g->data[w] = '\0'; // fits: the head came first
+    *len = w;
+    char *body = g->data;
+    g->data = NULL;
+    g->len = g->cap = 0;
+    return body;
+}
+
+// the message is complete: keep the connection if the server allows it
+static void fetch_done(Fetch *f, int ep) {
+    f->state = FETCH_DONE;
+    if (f->keep && f->end == f->in.len) {
+        epoll_ctl(ep, EPOLL_CTL_DEL, f->fd, NULL);
+        fcntl(f->fd, F_SETFL, fcntl(f->fd, F_GETFL) & ~O_NONBLOCK);
+        pool_put(f->key, f->fd);
+        f->fd = -1;
+    } else {
+        fetch_close(f);
+    }
+}
+
+// advance f as far as its socket allows without blocking
+static void fetch_step(Fetch *f, int ep) {
+    if (f->state == FETCH_CONNECTING) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (getsockopt(f->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+            fetch_close(f);
+            if (!fetch_connect(f, ep)) f->state = FETCH_FAILED;
+            return;
+        }
+        f->state = FETCH_SENDING;
+    }
+    if (f->state == FETCH_SENDING) {
+        while (f->sent < f->req_len) {
+            ssize_t k = send(f->fd, f->req + f->sent, (size_t)(f->req_len - f->sent), MSG_NOSIGNAL);
+            if (k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+            if (k < 0 && errno == EINTR) continue;
+            if (k <= 0) { fetch_error(f, ep); return; }
+            f->sent += (int)k;
+        }
+        f->state = FETCH_READING;
+        if (fetch_watch(ep, f, EPOLL_CTL_MOD, EPOLLIN) != 0) fetch_error(f, ep);
+        return;
+    }
+    if (f->state != FETCH_READING) return;
+    char chunk[16384];
+    int rc;
+    for (;;) {
+        ssize_t k = recv(f->fd, chunk, sizeof(chunk), 0);
+        if (k < 0 && errno == EINTR) continue;
+        if (k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) { rc = fetch_parse(f, 0); break; }
+        if (k < 0) { rc = -1; break; }
+        if (k == 0) { rc = fetch_parse(f, 1); break; }
+        if (grow_sink(chunk, (size_t)k, &f->in)) { rc = -1; break; }
+    }
+    if (rc < 0) fetch_error(f, ep);
+    else if (rc > 0) fetch_done(f, ep);
+}
+
+static int fetch_running(const Fetch *f) {
+    return f->state != FETCH_QUEUED && f->state != FETCH_DONE && f->state != FETCH_FAILED;
+}
+
+int nvx_http_get_many(const char *const *urls, int n, int max_parallel, int timeout_ms, char **results, size_t *lens) {
+    if (n <= 0) return 0;
+    if (max_parallel <= 0) max_parallel = FETCH_DEFAULT_PARALLEL;
+    client_lock();
+    client_init();
+    client_unlock();
+    Fetch *fs = calloc((size_t)n, sizeof(Fetch));
+    int ep = fs ? epoll_create1(EPOLL_CLOEXEC) : -1;
+    for (int i = 0; fs && i < n; ++i) {
+        Fetch *f = &fs[i];
+        f->fd = -1;
+        f->length = -1;
+        if (!urls[i]) { f->state = FETCH_FAILED; continue; }
+        char path[1024];
+        parse_url(urls[i], f->host, sizeof(f->host), f->port, sizeof(f->port), path, sizeof(path));
+        snprintf(f->key, sizeof(f->key), "%s:%s", f->host, f->port);
+        f->req_len = snprintf(f->req, sizeof(f->req), "GET %s HTTP/1.1\r\nHost: %s\r\n\r\n", path, f->host);
+        if (f->req_len < 0 || f->req_len >= (int)sizeof(f->req)) f->state = FETCH_FAILED;
+    }
+    // every distinct host is resolved once up front: no DNS query blocks the
+    // loop while requests are in flight and their deadlines are running
+    for (int i = 0; fs && i < n; ++i) {
+        Fetch *f = &fs[i];
+        if (f->state == FETCH_FAILED) continue;
+        int j = 0;
+        while (j < i && (fs[j].state == FETCH_FAILED || strcmp(fs[j].key, f->key) != 0)) j++;
+        if (j < i) f->addrs = fs[j].addrs;
+        else resolve(f->key, f->host, f->port, &f->addrs);
+    }
+    int next = 0, active = 0;
+    struct epoll_event evs[64];
+    while (ep >= 0) {
+        for (; active < max_parallel && next < n; ++next) {
+            Fetch *f = &fs[next];
+            if (f->state != FETCH_QUEUED) continue;
+            f->deadline = timeout_ms > 0 ? now_ms() + timeout_ms : 0;
+            if (fetch_start(f, ep)) active++;
+            else f->state = FETCH_FAILED;
+        }
+        if (!active) break;
+        long long now = now_ms(), first = 0;
+        for (int i = 0; i < next; ++i) {
+            if (fetch_running(&fs[i]) && fs[i].deadline && (!first || fs[i].deadline < first)) first = fs[i].deadline;
+        }
+        int wait = first ? (first > now ? (int)(first - now) : 0) : -1;
+        int nev = epoll_wait(ep, evs, 64, wait);
+        if (nev < 0 && errno != EINTR) break;
+        for (int k = 0; k < nev; ++k) {
+            Fetch *f = evs[k].data.ptr;
+            if (!fetch_running(f)) continue;
+            fetch_step(f, ep);
+            if (!fetch_running(f)) active--;
+        }
+        now = now_ms();
+        for (int i = 0; i < next; ++i) {
+            Fetch *f = &fs[i];
+            if (!fetch_running(f) || !f->deadline || now < f->deadline) continue;
+            fetch_close(f);
+            f->state = FETCH_FAILED;
+            active--;
+        }
+    }
+    int failed = 0;
+    for (int i = 0; i < n; ++i) {
+        size_t len = 0;
+        results[i] = NULL;
+        if (fs && fs[i].state == FETCH_DONE) results[i] = fetch_body(&fs[i], &len);
+        if (lens) lens[i] = len;
+        if (!results[i]) failed++;
+        if (fs) {
+            fetch_close(&fs[i]);
+            free(fs[i].in.data);
+        }
+    }
+    if (ep >= 0) close(ep);
+    free(fs);
+    return failed;
+}
+
+#else
+
+int nvx_http_get_many(const char *const *urls, int n, int max_parallel, int timeout_ms, char **results, size_t *lens) {
+    (void)max_parallel;
+    (void)timeout_ms;
+    int failed = 0;
+    for (int i = 0; i < n; ++i) {
+        size_t len = 0;
+        results[i] = urls[i] ? nvx_http_fetch("GET", urls[i], NULL, &len) : NULL;
+        if (lens) lens[i] = len;
+        if (!results[i]) failed++;
+    }
+    return failed;
+}
+
+#endif
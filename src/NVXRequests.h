@@ -5,8 +5,33 @@
 
 // simple HTTP client functions
 // url should be of form "http://hostname[:port]/path"
-// response buffer gets the full body (not headers); returns length or -1 on error
+// response buffer gets the body (not headers), truncated to fit; returns the
+// full body length or -1 on error. Requests use HTTP/1.1 keep-alive and reuse
+// pooled connections per host:port.
 int nvx_http_get(const char *url, char *response, size_t resp_size);
 int nvx_http_post(const char *url, const char *body, char *response, size_t resp_size);
 
+// Streaming: the body is passed to sink piece by piece as it arrives, straight
+// from the socket read buffer. A sink returning non-zero stops the transfer.
+// body may be NULL (no request body). Returns the number of body bytes
+// received, or -1 on error.
+typedef int (*nvx_http_sink)(const char *data, size_t len, void *ctx);
+long long nvx_http_stream(const char *method, const char *url, const char *body, nvx_http_sink sink, void *ctx);
+
+// whole body in a malloc'd, NUL-terminated buffer of any size (caller frees);
+// NULL on error. *len (if not NULL) receives the body length.
+char *nvx_http_fetch(const char *method, const char *url, const char *body, size_t *len);
+
+// GET every url concurrently. On Linux the requests run over non-blocking
+// sockets driven by one epoll loop, at most max_parallel at a time (0 = 8),
+// each failing if not complete timeout_ms after it started (0 = no limit);
+// elsewhere they run one after another. results[i] receives the body of
+// urls[i] (malloc'd, NUL-terminated, caller frees) or NULL if that request
+// failed, lens[i] (if lens is not NULL) its length. A NULL url fails.
+// Returns the number of requests that failed.
+int nvx_http_get_many(const char *const *urls, int n, int max_parallel, int timeout_ms, char **results, size_t *lens);
+
+// how long resolved host addresses are cached, in seconds (default 60, 0 = always resolve)
+void nvx_http_set_dns_ttl(int seconds);
+
 #endif // NVX_REQUESTS_H
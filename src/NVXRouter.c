@@ -0,0 +1,244 @@
+#include "NVXRouter.h"
+#include <stdlib.h>
+#include <string.h>
+
+// One tree holds every route; a node where routes end keeps a value per
+// method (method NULL = any). A node matches `prefix` (static text, empty for
+// parameter nodes) and then one of its children. Static children differ in
+// their first character, kept in `indices` so a step down the tree is one
+// memchr.
+typedef struct { char *method; void *value; } MethodValue;
+
+typedef struct Node {
+    char *prefix; size_t len;
+    char *indices;               // first character of each static child
+    struct Node **children; int nchildren;
+    struct Node *param;          // `:name` child
+    struct Node *wild;           // `*name` child, always a leaf
+    char *name;                  // parameter name of a param or wild node
+    MethodValue *values; int nvalues; // routes ending here
+} Node;
+
+struct NVXRouter {
+    Node *root;
+};
+
+static Node *node_new(const char *prefix, size_t len) {
+    Node *n = calloc(1, sizeof(Node));
+    if (!n) return NULL;
+    n->prefix = malloc(len + 1);
+    if (!n->prefix) { free(n); return NULL; }
+    memcpy(n->prefix, prefix, len);
+    n->prefix[len] = '\0';
+    n->len = len;
+    return n;
+}
+
+static void node_free(Node *n) {
+    if (!n) return;
+    for (int i = 0; i < n->nchildren; ++i) node_free(n->children[i]);
+    node_free(n->param);
+    node_free(n->wild);
+    for (int i = 0; i < n->nvalues; ++i) free(n->values[i].method);
+    free(n->values);
+    free(n->children);
+    free(n->indices);
+    free(n->prefix);
+    free(n->name);
+    free(n);
+}
+
+static int add_child(Node *n, Node *child) {
+    Node **nc = realloc(n->children, (size_t)(n->nchildren + 1) * sizeof(Node *));
+    if (!nc) return -1;
+    n->children = nc;
+    char *ni = realloc(n->indices, (size_t)n->nchildren + 1);
+    if (!ni) return -1;
+    n->indices = ni;
+    n->children[n->nchildren] = child;
+    n->indices[n->nchildren] = child->prefix[0];
+    n->nchildren++;
+    return 0;
+}
+
+// keep the first `at` characters of n's prefix; the rest and everything below
+// n move into a new single child
+static int split(Node *n, size_t at) {
+    Node *rest = node_new(n->prefix + at, n->len - at);
+    Node **kids = malloc(sizeof(Node *));
+    char *idx = malloc(1);
+    if (!rest || !kids || !idx) { node_free(rest); free(kids); free(idx); return -1; }
+    rest->indices = n->indices;
+    rest->children = n->children;
+    rest->nchildren = n->nchildren;
+    rest->param = n->param;
+    rest->wild = n->wild;
+    rest->values = n->values;
+    rest->nvalues = n->nvalues;
+    kids[0] = rest;
+    idx[0] = rest->prefix[0];
+    n->children = kids;
+    n->indices = idx;
+    n->nchildren = 1;
+    n->param = n->wild = NULL;
+    n->values = NULL;
+    n->nvalues = 0;
+    n->prefix[at] = '\0';
+    n->len = at;
+    return 0;
+}
+
+static char *dup_n(const char *s, size_t n) {
+    char *d = malloc(n + 1);
+    if (d) { memcpy(d, s, n); d[n] = '\0'; }
+    return d;
+}
+
+// value of n for method (length len), falling back to the any-method one
+static void *node_value(const Node *n, const char *method, size_t len) {
+    void *any = NULL;
+    for (int i = 0; i < n->nvalues; ++i) {
+        const char *m = n->values[i].method;
+        if (!m) any = n->values[i].value;
+        else if (strncmp(m, method, len) == 0 && m[len] == '\0') return n->values[i].value;
+    }
+    return any;
+}
+
+static int set_value(Node *n, const char *method, void *value) {
+    for (int i = 0; i < n->nvalues; ++i) {
+        const char *m = n->values[i].method;
+        if (m ? method && strcmp(m, method) == 0 : !method) return -1; // already routed
+    }
+    MethodValue *nv = realloc(n->values, (size_t)(n->nvalues + 1) * sizeof(MethodValue));
+    if (!nv) return -1;
+    n->values = nv;
+    char *m = NULL;
+    if (method && !(m = dup_n(method, strlen(method)))) return -1;
+    n->values[n->nvalues].method = m;
+    n->values[n->nvalues].value = value;
+    n->nvalues++;
+    return 0;
+}
+
+static int insert(Node *n, const char *method, const char *p, void *value) {
+    int nparams = 0;
+    for (;;) {
+        if (!*p) return set_value(n, method, value);
+        if (*p == ':' || *p == '*') { // only seen at the start of a segment
+            const char *e = p + 1;
+            while (*e && *e != '/') e++;
+            size_t nlen = (size_t)(e - p - 1);
+            if (++nparams > NVX_MAX_PARAMS) return -1;
+            if (*p == '*') {
+                if (*e) return -1; // a wildcard ends the pattern
+                if (n->wild) {
+                    if (strlen(n->wild->name) != nlen || strncmp(n->wild->name, p + 1, nlen) != 0) return -1;
+                } else {
+                    Node *w = node_new("", 0);
+                    if (!w || !(w->name = dup_n(p + 1, nlen))) { node_free(w); return -1; }
+                    n->wild = w;
+                }
+                return set_value(n->wild, method, value);
+            }
+            if (!nlen) return -1;
+            if (n->param) {
+                if (strlen(n->param->name) != nlen || strncmp(n->param->name, p + 1, nlen) != 0) return -1;
+            } else {
+                Node *pn = node_new("", 0);
+                if (!pn || !(pn->name = dup_n(p + 1, nlen))) { node_free(pn); return -1; }
+                n->param = pn;
+            }
+            n = n->param;
+            p = e;
+            continue;
+        }
+        // static text up to the next parameter segment
+        size_t run = 1;
+        while (p[run] && !(p[run - 1] == '/' && (p[run] == ':' || p[run] == '*'))) run++;
+        const char *hit = n->nchildren ? memchr(n->indices, p[0], (size_t)n->nchildren) : NULL;
+        if (!hit) {
+            Node *c = node_new(p, run);
+            if (!c || add_child(n, c) < 0) { node_free(c); return -1; }
+            n = c;
+            p += run;
+            continue;
+        }
+        Node *c = n->children[hit - n->indices];
+        size_t l = 0;
+        while (l < c->len && l < run && c->prefix[l] == p[l]) l++;
+        if (l < c->len && split(c, l) < 0) return -1;
+        n = c;
+        p += l;
+    }
+}
+
+typedef struct { const char *method; size_t len; } Method;
+
+static void *match(const Node *n, Method m, const char *path, size_t len, NVXParams *ps) {
+    void *v;
+    if (!len && (v = node_value(n, m.method, m.len))) return v;
+    if (len) {
+        const char *hit = n->nchildren ? memchr(n->indices, path[0], (size_t)n->nchildren) : NULL;
+        if (hit) {
+            const Node *c = n->children[hit - n->indices];
+            if (c->len <= len && memcmp(c->prefix, path, c->len) == 0) {
+                if ((v = match(c, m, path + c->len, len - c->len, ps))) return v;
+            }
+        }
+        if (n->param && path[0] != '/' && ps->count < NVX_MAX_PARAMS) {
+            const char *slash = memchr(path, '/', len);
+            size_t seg = slash ? (size_t)(slash - path) : len;
+            NVXParam *pp = &ps->items[ps->count++];
+            pp->name = n->param->name;
+            pp->value = path;
+            pp->value_len = seg;
+            if ((v = match(n->param, m, path + seg, len - seg, ps))) return v;
+            ps->count--;
+        }
+    }
+    if (n->wild && ps->count < NVX_MAX_PARAMS && (v = node_value(n->wild, m.method, m.len))) {
+        NVXParam *pp = &ps->items[ps->count++];
+        pp->name = n->wild->name;
+        pp->value = path;
+        pp->value_len = len;
+        return v;
+    }
+    return NULL;
+}
+
+NVXRouter *nvx_router_new(void) {
+    NVXRouter *r = calloc(1, sizeof(NVXRouter));
+    if (r && !(r->root = node_new("", 0))) { free(r); return NULL; }
+    return r;
+}
+
+void nvx_router_free(NVXRouter *r) {
+    if (!r) return;
+    node_free(r->root);
+    free(r);
+}
+
+int nvx_router_add(NVXRouter *r, const char *method, const char *pattern, void *value) {
+    if (!value || pattern[0] != '/') return -1;
+    return insert(r->root, method, pattern, value);
+}
+
+void *nvx_router_find(const NVXRouter *r, const char *method, size_t method_len,
+                      const char *path, size_t len, NVXParams *params) {
+    const char *q = memchr(path, '?', len);
+    if (q) len = (size_t)(q - path);
+    params->count = 0;
+    Method m = { method, method_len };
+    return match(r->root, m, path, len, params);
+}
+
+const char *nvx_param_get(const NVXParams *params, const char *name, size_t *len) {
+    for (int i = 0; i < params->count; ++i) {
+        if (strcmp(params->items[i].name, name) == 0) {
+            if (len) *len = params->items[i].value_len;
+            return params->items[i].value;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,54 @@
+#ifndef NVX_ROUTER_H
+#define NVX_ROUTER_H
+
+#include <stddef.h>
+
+// HTTP request router: a compressed radix tree over paths whose nodes keep a
+// route per method; a route added without a method matches any method.
+//
+// A pattern is a path starting with '/'. A segment written `:name` matches any
+// one non-empty segment; a final `*name` (or a bare `*`) matches the rest of the
+// path, possibly empty. At each node static text is tried first, then a
+// parameter, then a wildcard, so `/users/new` wins over `/users/:id`.
+//
+// Routes are added before serving; lookups only read the tree and may run on
+// many threads at once.
+
+#define NVX_MAX_PARAMS 8
+
+// a captured parameter: name points into the router, value into the looked-up
+// path (not NUL-terminated), so a lookup allocates nothing
+typedef struct {
+    const char *name;
+    const char *value;
+    size_t value_len;
+} NVXParam;
+
+typedef struct {
+    NVXParam items[NVX_MAX_PARAMS];
+    int count;
+} NVXParams;
+
+typedef struct NVXRouter NVXRouter;
+
+// NULL on allocation failure
+NVXRouter *nvx_router_new(void);
+void nvx_router_free(NVXRouter *r);
+
+// method is e.g. "GET", or NULL for any method. value must not be NULL.
+// Returns 0, or -1 if the pattern is malformed, has more than NVX_MAX_PARAMS
+// parameters, clashes with a route already added (same route, or a different
+// parameter name at the same place), or memory runs out.
+int nvx_router_add(NVXRouter *r, const char *method, const char *pattern, void *value);
+
+// value of the route matching method and path (lengths given; the path ends
+// at len or at a '?'), NULL if none. The most specific path wins; for the
+// same pattern a route for the method wins over an any-method one. params
+// receives the captures of the match.
+void *nvx_router_find(const NVXRouter *r, const char *method, size_t method_len,
+                      const char *path, size_t len, NVXParams *params);
+
+// the value of the named parameter, or NULL; *len receives its length
+const char *nvx_param_get(const NVXParams *params, const char *name, size_t *len);
+
+#endif // NVX_ROUTER_H
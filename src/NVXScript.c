@@ -1,18 +1,34 @@
 #include "NVXScript.h"
 #include "NVXVars.h"
+#include "NVXContext.h"
 #include "NVXMath.h"
 #include "NVXJSON.h"
+#include "NVXRequests.h"
+#include "NVXProgram.h"
+#include "NVXLex.h"
+#include "NVXArena.h"
+#include "NVXProcess.h"
+#include "NVXNet.h"
+#include "NVXStatic.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <math.h>
+#include <errno.h>
 #ifdef _WIN32
 #include <windows.h>
 #else
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #endif
 
+// nvx.http_get_many: requests in flight at once, and how long each may take
+#define HTTP_MANY_PARALLEL 8
+#define HTTP_MANY_TIMEOUT_MS 10000
+
 // Trim helpers
 static void ltrim(char *s) {
     char *p = s;
@@ -28,7 +44,8 @@ static void rtrim(char *s) {
 void trim(char *s) { ltrim(s); rtrim(s); }
 
 // Delay helper - resets delay after use so it only affects one statement
-void do_delay() {
+void do_delay(NVXContext *ctx) {
+    int script_delay = ctx->delay;
     if (script_delay < 0) return;
 #ifdef _WIN32
     if (script_delay == 0) {
@@ -45,789 +62,824 @@ void do_delay() {
         sleep((unsigned int)script_delay);
     }
 #endif
-    script_delay = -1;  // Reset after use so delay only affects one statement
+    ctx->delay = -1;  // Reset after use so delay only affects one statement
 }
 
-// forward declare stream interpreter
-void interpret_stream(FILE *file, char *first_line, int parent_exec);
-
-// Execute a system command via the host shell. Returns exit code.
+// Execute a system command via the host shell. Returns its exit code.
 int execute_sys_command(const char *cmd) {
     if (!cmd) return -1;
-    int rc = system(cmd);
-    return rc;
-}
-
-void execute_print(char *line) {
-    char *start = strchr(line, '(');
-    if (!start) return;
-    start++;
-
-    char *end = strrchr(start, ')');
-    if (!end) return;
-    *end = '\0';
-    
-    char full_content[1024];
-    strncpy(full_content, start, sizeof(full_content)-1); full_content[sizeof(full_content)-1] = '\0';
-    trim(full_content);
-
-    int i = 0;
-    while (full_content[i]) {
-        while (full_content[i] && isspace((unsigned char)full_content[i])) i++;
-        if (!full_content[i]) break;
-
-        char arg[512];
-        int j = 0;
-        int in_quotes = 0;
-        while (full_content[i] && j < (int)sizeof(arg)-1) {
-            if (full_content[i] == '"') {
-                in_quotes = !in_quotes;
-                arg[j++] = full_content[i++];
-            } else if (full_content[i] == ',' && !in_quotes) {
-                break;
-            } else {
-                arg[j++] = full_content[i++];
-            }
-        }
-        arg[j] = '\0';
-        while (j > 0 && isspace((unsigned char)arg[j-1])) arg[--j] = '\0';
-
-        if (full_content[i] == ',') i++;
-
-        if (strlen(arg) > 0) {
-            char trimmed_arg[512];
-            strncpy(trimmed_arg, arg, sizeof(trimmed_arg)-1); trimmed_arg[sizeof(trimmed_arg)-1] = '\0';
-            trim(trimmed_arg);
-            size_t len = strlen(trimmed_arg);
-            if (len >= 2 && trimmed_arg[0] == '"' && trimmed_arg[len - 1] == '"') {
-                for (size_t k = 1; k < len - 1; k++) {
-                    putchar(trimmed_arg[k]);
-                }
-            }
-            else if (isalpha((unsigned char)trimmed_arg[0]) || trimmed_arg[0] == '_') {
-                int is_simple_var = 1;
-                for (size_t k = 0; k < len; k++) {
-                    if (!isalnum((unsigned char)trimmed_arg[k]) && trimmed_arg[k] != '_') { is_simple_var = 0; break; }
-                }
-                if (is_simple_var) {
-                    int vtype = get_var_type(trimmed_arg);
-                    if (vtype == 2 || vtype == 3) {
-                        const char *value = get_variable(trimmed_arg);
-                        if (value) {
-                            printf("%s", value);
-                        }
-                    } else {
-                        double dres;
-                        if (evaluate_math_expr(trimmed_arg, &dres)) {
-                            if (fabs(dres - round(dres)) < 1e-9) printf("%lld", (long long)llround(dres));
-                            else printf("%g", dres);
-                        } else {
-                            const char *value = get_variable(trimmed_arg);
-                            if (value) {
-                                printf("%s", value);
-                            }
-                        }
-                    }
-                }
-            }
-            else {
-                double dres;
-                if (evaluate_math_expr(trimmed_arg, &dres)) {
-                    if (fabs(dres - round(dres)) < 1e-9) printf("%lld", (long long)llround(dres));
-                    else printf("%g", dres);
-                } else if (strncmp(trimmed_arg, "nvx.json_get(", 13) == 0) {
-                    // evaluate json_get in print context; ignore quotes
-                    char copy[1024]; strncpy(copy, trimmed_arg, sizeof(copy)-1); copy[sizeof(copy)-1]='\0';
-                    // reuse assignment logic by temporarily storing to temp var
-                    // naive: call function and capture output
-                    char *p = strchr(copy,'(');
-                    if (p) {
-                        p++;
-                        char *q = strrchr(p,')'); if(q)*q='\0';
-                        char jsonstr[1024]=""; char keystr[256]="";
-                        int inq=0, idx=-1;
-                        for(int i=0; p[i]; i++){
-                            if(p[i]=='"') inq=!inq;
-                            if(p[i]==',' && !inq){idx=i;break;}
-                        }
-                        if(idx>=0){strncpy(jsonstr,p,idx);jsonstr[idx]='\0'; strncpy(keystr,p+idx+1,sizeof(keystr)-1);keystr[sizeof(keystr)-1]='\0';}
-                        else strncpy(jsonstr,p,sizeof(jsonstr)-1);
-                        trim(jsonstr); trim(keystr);
-                        if(jsonstr[0]=='"' && jsonstr[strlen(jsonstr)-1]=='"'){memmove(jsonstr,jsonstr+1,strlen(jsonstr)); jsonstr[strlen(jsonstr)-1]='\0';}
-                        if(keystr[0]=='"' && keystr[strlen(keystr)-1]=='"'){memmove(keystr,keystr+1,strlen(keystr)); keystr[strlen(keystr)-1]='\0';}
-                        char outbuf[1024]="";
-                        if(nvx_json_get(jsonstr,keystr,outbuf,sizeof(outbuf))) printf("%s", outbuf);
-                    }
-                } else {
-                    const char *value = get_variable(trimmed_arg);
-                    if (value) {
-                        printf("%s", value);
-                    }
-                }
-            }
+    return nvx_process_run(cmd, NVX_PROC_SHELL, NULL, NULL);
+}
+
+// read a whole file into a NUL-terminated heap buffer; NULL if it cannot be read
+static char *read_file(const char *filename, size_t *out_len) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) return NULL;
+    size_t cap = 4096, len = 0;
+    char *buf = nvx_malloc(cap);
+    size_t r;
+    while (buf && (r = fread(buf + len, 1, cap - len - 1, file)) > 0) {
+        len += r;
+        if (len + 1 == cap) {
+            char *grown = nvx_realloc(buf, cap * 2);
+            if (!grown) { free(buf); buf = NULL; break; }
+            buf = grown; cap *= 2;
         }
     }
-    printf("\n");
-    fflush(stdout);
-    do_delay();
-}
-
-void execute_math(char *line) {
-    char *start = strchr(line, '(');
-    if (!start) return;
-    start++;
-    char *end = strrchr(start, ')');
-    if (!end) return;
-    *end = '\0';
-
-    char *eq = strchr(start, '=');
-    if (eq) {
-        *eq = '\0';
-        char lhs[64]; char rhs[256];
-        strncpy(lhs, start, sizeof(lhs)-1); lhs[sizeof(lhs)-1] = '\0';
-        strncpy(rhs, eq+1, sizeof(rhs)-1); rhs[sizeof(rhs)-1] = '\0';
-        trim(lhs); trim(rhs);
-        double res;
-        if (!evaluate_math_expr(rhs, &res)) { printf("NVD Error: Invalid math expression.\n"); return; }
-        char buf[100];
-        if (fabs(res - round(res)) < 1e-9) snprintf(buf, sizeof(buf), "%lld", (long long)llround(res));
-        else snprintf(buf, sizeof(buf), "%g", res);
-        set_variable(lhs, buf);
-        return;
-    }
+    fclose(file);
+    if (!buf) return NULL;
+    buf[len] = '\0';
+    *out_len = len;
+    return buf;
+}
 
-    double res;
-    if (evaluate_math_expr(start, &res)) {
-        if (fabs(res - round(res)) < 1e-9) printf("%lld\n", (long long)llround(res));
-        else printf("%g\n", res);
-        return;
-    }
-    printf("NVD Error: Invalid math statement.\n");
-    do_delay();
-}
-
-static char pushback_line[512];
-static int have_pushback = 0;
-
-int eval_condition(const char *cond) {
-    char buf[512]; strncpy(buf, cond, sizeof(buf)-1); buf[sizeof(buf)-1] = '\0'; trim(buf);
-    const char *ops[] = {"==","!=","<=",">=","<",">","=", NULL};
-    for (int i = 0; ops[i]; i++) {
-        char *pos = strstr(buf, ops[i]);
-        if (pos) {
-            char left[256]; char right[256];
-            int olen = strlen(ops[i]);
-            strncpy(left, buf, pos - buf); left[pos-buf] = '\0';
-            strncpy(right, pos + olen, sizeof(right)-1); right[sizeof(right)-1] = '\0';
-            trim(left); trim(right);
-            double a, b;
-            int anum = evaluate_math_expr(left, &a);
-            int bnum = evaluate_math_expr(right, &b);
-            if (anum && bnum) {
-                if (strcmp(ops[i], "==") == 0 || strcmp(ops[i], "=") == 0) return fabs(a-b) < 1e-9;
-                if (strcmp(ops[i], "!=") == 0) return fabs(a-b) >= 1e-9;
-                if (strcmp(ops[i], "<=") == 0) return a <= b;
-                if (strcmp(ops[i], ">=") == 0) return a >= b;
-                if (strcmp(ops[i], "<") == 0) return a < b;
-                if (strcmp(ops[i],">") == 0) return a > b;
-            } else {
-                const char *lv = left; const char *rv = right;
-                const char *vl = get_variable(left); if (vl) lv = vl;
-                const char *vr = get_variable(right); if (vr) rv = vr;
-                if (strcmp(ops[i], "==") == 0) return strcmp(lv, rv) == 0;
-                if (strcmp(ops[i], "!=") == 0) return strcmp(lv, rv) != 0;
-                return 0;
-            }
+// Script source: a regular file is mapped read-only in one call; pipes and
+// other streams (and Windows) fall back to a single growing read.
+static char *map_file(const char *filename, size_t *out_len, int *mapped) {
+    *mapped = 0;
+#ifndef _WIN32
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (m != MAP_FAILED) {
+            madvise(m, (size_t)st.st_size, MADV_SEQUENTIAL);
+            *mapped = 1;
+            *out_len = (size_t)st.st_size;
+            return m;
         }
+    } else {
+        close(fd);
+    }
+#endif
+    return read_file(filename, out_len);
+}
+
+static void unmap_file(char *data, size_t len, int mapped) {
+#ifndef _WIN32
+    if (mapped) { munmap(data, len); return; }
+#endif
+    (void)len; (void)mapped;
+    free(data);
+}
+
+static int is_identifier(const char *s) {
+    if (!(isalpha((unsigned char)s[0]) || s[0] == '_')) return 0;
+    for (const char *p = s + 1; *p; ++p) {
+        if (!isalnum((unsigned char)*p) && *p != '_') return 0;
     }
-    double v;
-    if (evaluate_math_expr(buf, &v)) return fabs(v) > 1e-9;
-    const char *s = get_variable(buf);
-    if (s) return strlen(s) > 0;
+    return 1;
+}
+
+static void print_number(double v) {
+    char buf[64];
+    nvx_format_number(v, buf, sizeof(buf));
+    fputs(buf, stdout);
+}
+
+// parse a bare literal as a number; returns the kind it fits (0 if not numeric)
+static int parse_number_literal(const char *s, long long *iv, double *dv) {
+    char *end;
+    if (!*s) return 0;
+    errno = 0;
+    *iv = strtoll(s, &end, 10);
+    if (*end == '\0' && errno == 0) return VAL_INT;
+    *dv = strtod(s, &end);
+    if (*end == '\0') return VAL_DOUBLE;
     return 0;
 }
 
-char *collect_block(FILE *file, char *after_brace) {
-    size_t cap = 4096; size_t len = 0; char *out = malloc(cap);
-    if (!out) return NULL;
-    out[0] = '\0';
-    int depth = 1;
-    if (after_brace && *after_brace) {
-        strcat(out, after_brace);
-        strcat(out, "\n");
-    }
-    char line[512];
-    while (fgets(line, sizeof(line), file)) {
-        for (char *p = line; *p; ++p) {
-            if (*p == '{') depth++;
-            else if (*p == '}') depth--;
-        }
-        size_t l = strlen(line);
-        if (len + l + 1 > cap) { cap *= 2; out = realloc(out, cap); }
-        strcat(out, line);
-        len += l;
-        if (depth == 0) break;
-    }
-    return out;
-}
-
-void interpret_stream(FILE *file, char *first_line, int parent_exec) {
-    char linebuf[512];
-    if (first_line) strncpy(linebuf, first_line, sizeof(linebuf)-1);
-    else {
-        if (have_pushback) { strncpy(linebuf, pushback_line, sizeof(linebuf)-1); have_pushback = 0; }
-        else if (!fgets(linebuf, sizeof(linebuf), file)) return;
-    }
-    while (1) {
-        if (!linebuf[0]) {
-            if (have_pushback) {
-                strncpy(linebuf, pushback_line, sizeof(linebuf)-1);
-                have_pushback = 0;
-            } else if (!fgets(linebuf, sizeof(linebuf), file)) break;
-        }
-        char tline[512]; strncpy(tline, linebuf, sizeof(tline)-1); tline[sizeof(tline)-1] = '\0'; trim(tline);
-        if (strlen(tline) == 0) { linebuf[0] = '\0'; continue; }
-        if (strncmp(tline, "void ", 5) == 0) {
-            char name[64] = "";
-            char *brace = strchr(linebuf, '{');
-            if (brace) {
-                char *p = linebuf + 4;
-                while (*p && isspace((unsigned char)*p)) p++;
-                int j = 0;
-                while (*p && !isspace((unsigned char)*p) && *p != '{' && j < (int)sizeof(name)-1) name[j++] = *p++;
-                name[j] = '\0'; trim(name);
-                char *after = brace + 1;
-                char *blk = collect_block(file, after);
-                if (blk) {
-                    store_named_block(name, blk);
-                    free(blk);
-                }
-                linebuf[0] = '\0';
-                if (have_pushback) { strncpy(linebuf, pushback_line, sizeof(linebuf)-1); have_pushback = 0; }
-                else if (!fgets(linebuf, sizeof(linebuf), file)) break;
-                continue;
-            }
-        }
-        if ((strncmp(tline, "if ", 3) == 0) || (strncmp(tline, "if(", 3) == 0) || (strncmp(tline, "if\t",3)==0)) {
-            char condbuf[256] = "";
-            char *brace = strchr(linebuf, '{');
-            if (brace) {
-                char *start = strstr(linebuf, "if"); if (start) start += 2;
-                int upto = brace - linebuf;
-                int len = upto - (start - linebuf);
-                if (len > 0 && len < (int)sizeof(condbuf)) strncpy(condbuf, start, len);
-                condbuf[len] = '\0';
-            } else {
-                char *p = strchr(linebuf, '(');
-                char *q = strrchr(linebuf, ')');
-                if (p && q && q > p) { strncpy(condbuf, p+1, q-p-1); condbuf[q-p-1] = '\0'; }
-            }
-            trim(condbuf);
-            if (condbuf[0] == '(' && condbuf[strlen(condbuf)-1] == ')') {
-                condbuf[strlen(condbuf)-1] = '\0';
-                memmove(condbuf, condbuf+1, strlen(condbuf));
-            }
-            char *after = NULL;
-            if (brace) after = brace + 1;
-            char *if_block = collect_block(file, after);
-            int taken = 0;
-            if (parent_exec && eval_condition(condbuf)) {
-                taken = 1;
-                    char *ln = strtok(if_block, "\n");
-                    while (ln) { interpret_line_simple(file, ln); do_delay(); ln = strtok(NULL, "\n"); }
-            }
-            free(if_block);
-            while (1) {
-                char look[512]; 
-                if (!fgets(look, sizeof(look), file)) break;
-                char tlook[512]; strncpy(tlook, look, sizeof(tlook)-1); tlook[sizeof(tlook)-1] = '\0'; trim(tlook);
-                
-                if (strncmp(tlook, "else if", 7) == 0 || strncmp(tlook, "elseif", 6) == 0) {
-                    char elseif_cond[256] = "";
-                    char *brace = strchr(look, '{');
-                    if (brace) {
-                        char *start = strstr(look, "if"); if (start) start += 2;
-                        int upto = brace - look;
-                        int len = upto - (start - look);
-                        if (len > 0 && len < (int)sizeof(elseif_cond)) strncpy(elseif_cond, start, len);
-                        elseif_cond[len] = '\0';
-                    } else {
-                        char *p = strchr(look, '(');
-                        char *q = strrchr(look, ')');
-                        if (p && q && q > p) { strncpy(elseif_cond, p+1, q-p-1); elseif_cond[q-p-1] = '\0'; }
-                    }
-                    trim(elseif_cond);
-                    if (elseif_cond[0] == '(' && elseif_cond[strlen(elseif_cond)-1] == ')') {
-                        elseif_cond[strlen(elseif_cond)-1] = '\0';
-                        memmove(elseif_cond, elseif_cond+1, strlen(elseif_cond));
-                    }
-                    
-                    char *after = NULL;
-                    if (brace) after = brace + 1;
-                    char *elseif_block = collect_block(file, after);
-                    
-                    if (!taken && parent_exec && eval_condition(elseif_cond)) {
-                        taken = 1;
-                        char *ln = strtok(elseif_block, "\n");
-                        while (ln) { interpret_line_simple(file, ln); do_delay(); ln = strtok(NULL, "\n"); }
-                    }
-                    free(elseif_block);
-                    continue;
-                    
-                } else if (strncmp(tlook, "else", 4) == 0) {
-                    char *bpos = strchr(look, '{');
-                    char *after = NULL;
-                    if (bpos) after = bpos + 1;
-                    char *else_block = collect_block(file, after);
-                    
-                    if (!taken && parent_exec && else_block) {
-                        char *ln = strtok(else_block, "\n");
-                        while (ln) { interpret_line_simple(file, ln); do_delay(); ln = strtok(NULL, "\n"); }
-                    }
-                    if (else_block) free(else_block);
-                    break;
-                } else {
-                    strncpy(pushback_line, look, sizeof(pushback_line)-1); 
-                    have_pushback = 1;
-                    break;
-                }
-            }
-            linebuf[0] = '\0';
-            if (have_pushback) { strncpy(linebuf, pushback_line, sizeof(linebuf)-1); have_pushback = 0; }
-            else if (!fgets(linebuf, sizeof(linebuf), file)) break;
-            continue;
-        }
-        if (strncmp(tline, "else", 4) != 0) {
-            interpret_line_simple(file, linebuf);
-            do_delay();
+void print_literal_arg(NVXContext *ctx, const char *text) {
+    (void)ctx;
+    fputs(text, stdout);
+}
+
+void print_var_arg(NVXContext *ctx, const char *name) {
+    int slot = nvx_find_var_slot(ctx, name);
+    if (slot >= 0 && ctx->vars[slot].kind != VAL_UNSET) {
+        // a def.var holding text that is not a number prints as the number it
+        // reads as ("abc" and "" print 0)
+        double d;
+        if (ctx->vars[slot].type == 1 && ctx->vars[slot].kind == VAL_STRING && nvx_var_number(ctx, slot, &d)) {
+            print_number(d);
+            return;
         }
-        linebuf[0] = '\0';
-        if (have_pushback) { strncpy(linebuf, pushback_line, sizeof(linebuf)-1); have_pushback = 0; }
-        else if (!fgets(linebuf, sizeof(linebuf), file)) break;
+        // numbers are formatted here, strings print as stored
+        const char *value = nvx_var_text(ctx, slot);
+        if (value) printf("%s", value);
+        return;
     }
+    print_expr_arg(ctx, name);
 }
 
-void interpret_line_simple(FILE *file, char *line) {
-    line[strcspn(line, "\n")] = 0;
-    trim(line);
-    if (strlen(line) == 0)
-        return;
-    if (strcmp(line, "NevoidX.commands") == 0) {
-        printf("Available commands:\n");
-        printf(" - def.var=VAR1,VAR2     : declare numeric variables\n");
-        printf(" - def.str=NAME1,NAME2   : declare string variables\n");
-        printf(" - def.math=NAME1,NAME2  : declare math-expression variables\n");
-        printf(" - VAR=VALUE           : assign literal, quoted string, or existing var\n");
-        printf(" - VAR=math(expr)      : evaluate expr and assign result to VAR\n");
-        printf(" - VAR=math(VARNAME)   : evaluate expression stored in VARNAME and assign\n");
-        printf(" - VAR=user.input_var(\"prompt\") : numeric input\n");
-        printf(" - VAR=user.input_str(\"prompt\") : string input\n");
-        printf(" - VAR=user.input_math(\"prompt\") : raw expression input (stored as string)\n");
-        printf(" - VAR=user.choice_var(\"prompt\",opt1,opt2,...) : choose option (stores option text)\n");
-        printf(" - VAR=user.choice_str(\"prompt\",\"optA\",\"optB\") : choose string option\n");
-        printf(" - print(...)             : print literals, vars, or math expressions\n");
-        printf(" - math(expr)             : evaluate expression and print result\n");
-        printf(" - if (cond) { ... } else if (cond) { ... } else { ... } : conditional blocks\n");
-        printf(" - delay=N                : set script delay (N seconds). 0 waits for Enter.\n");
-        do_delay();
+void print_expr_arg(NVXContext *ctx, const char *expr) {
+    double dres;
+    if (nvx_evaluate_math(ctx, expr, &dres)) {
+        print_number(dres);
         return;
     }
-    if (strncmp(line, "def.var=", 8) == 0) {
-        char *list = line + 8;
-        char buf[512];
-        strncpy(buf, list, sizeof(buf)-1); buf[sizeof(buf)-1] = '\0';
-        trim(buf);
-        int i = 0;
-        while (buf[i]) {
-            char var_name[64];
-            int j = 0;
-            while (buf[i] && isspace((unsigned char)buf[i])) i++;
-            while (buf[i] && buf[i] != ',' && j < (int)sizeof(var_name)-1) {
-                var_name[j++] = buf[i++];
-            }
-            while (j > 0 && isspace((unsigned char)var_name[j-1])) j--;
-            var_name[j] = '\0';
-            if (j > 0) {
-                set_var_type(var_name, 1); // type 1 = numeric var
-            }
-            if (buf[i] == ',') i++;
-        }
+    if (strncmp(expr, "nvx.json_get(", 13) == 0) {
+        NVXSpan inner, arg[2] = {{"", 0}, {"", 0}};
+        nvx_lex_call_args(expr, strlen(expr), &inner);
+        nvx_lex_split_args(inner.start, inner.len, arg, 2);
+        int literal = arg[0].len && arg[0].start[0] == '"';
+        NVXArenaMark m = nvx_arena_mark(&ctx->arena);
+        NVXSpan js = nvx_span_unquote(arg[0]), ks = nvx_span_unquote(arg[1]);
+        char *json = nvx_arena_strndup(&ctx->arena, js.start, js.len);
+        char *key = nvx_arena_strndup(&ctx->arena, ks.start, ks.len);
+        char outbuf[1024] = "";
+        const char *src = json;
+        if (json && !literal && nvx_get_variable(ctx, json)) src = nvx_get_variable(ctx, json); // as in NAME=nvx.json_get(...)
+        if (src && key && nvx_json_get(src, key, outbuf, sizeof(outbuf))) printf("%s", outbuf);
+        nvx_arena_release(&ctx->arena, m);
         return;
     }
-    if (strncmp(line, "def.str=", 8) == 0) {
-        char *list = line + 8;
-        char buf[512];
-        strncpy(buf, list, sizeof(buf)-1); buf[sizeof(buf)-1] = '\0';
-        trim(buf);
-        int i = 0;
-        while (buf[i]) {
-            char var_name[64];
-            int j = 0;
-            while (buf[i] && isspace((unsigned char)buf[i])) i++;
-            while (buf[i] && buf[i] != ',' && j < (int)sizeof(var_name)-1) {
-                var_name[j++] = buf[i++];
-            }
-            while (j > 0 && isspace((unsigned char)var_name[j-1])) j--;
-            var_name[j] = '\0';
-            if (j > 0) {
-                set_var_type(var_name, 2); // type 2 = string
-            }
-            if (buf[i] == ',') i++;
-        }
-        return;
+    const char *value = nvx_get_variable(ctx, expr);
+    if (value) printf("%s", value);
+}
+
+void print_help(NVXContext *ctx) {
+    (void)ctx;
+    printf("Available commands:\n");
+    printf(" - def.var=VAR1,VAR2     : declare numeric variables\n");
+    printf(" - def.str=NAME1,NAME2   : declare string variables\n");
+    printf(" - def.math=NAME1,NAME2  : declare math-expression variables\n");
+    printf(" - VAR=VALUE           : assign literal, quoted string, or existing var\n");
+    printf(" - VAR=math(expr)      : evaluate expr and assign result to VAR\n");
+    printf(" - VAR=math(VARNAME)   : evaluate expression stored in VARNAME and assign\n");
+    printf(" - VAR=user.input_var(\"prompt\") : numeric input\n");
+    printf(" - VAR=user.input_str(\"prompt\") : string input\n");
+    printf(" - VAR=user.input_math(\"prompt\") : raw expression input (stored as string)\n");
+    printf(" - VAR=user.choice_var(\"prompt\",opt1,opt2,...) : choose option (stores option text)\n");
+    printf(" - VAR=user.choice_str(\"prompt\",\"optA\",\"optB\") : choose string option\n");
+    printf(" - print(...)             : print literals, vars, or math expressions\n");
+    printf(" - math(expr)             : evaluate expression and print result\n");
+    printf(" - if (cond) { ... } else if (cond) { ... } else { ... } : conditional blocks\n");
+    printf(" - void name { ... } / goto name : named blocks\n");
+    printf(" - delay=N                : set script delay (N seconds). 0 waits for Enter.\n");
+}
+
+// declare a comma separated list of names: 1=numeric, 2=string, 3=math (expression string)
+void declare_variables(NVXContext *ctx, const char *list, int type) {
+    NVXSpan rest = { list, strlen(list) }, name[2];
+    int n;
+    while ((n = nvx_lex_split_args(rest.start, rest.len, name, 2)) > 0) {
+        int slot = name[0].len ? nvx_var_slot_n(ctx, name[0].start, name[0].len) : -1;
+        if (slot >= 0) ctx->vars[slot].type = type;
+        if (n < 2) break;
+        rest = name[1];
     }
-    if (strncmp(line, "def.math=", 9) == 0) {
-        char *list = line + 9;
-        char buf[512];
-        strncpy(buf, list, sizeof(buf)-1); buf[sizeof(buf)-1] = '\0';
-        trim(buf);
-        int i = 0;
-        while (buf[i]) {
-            char var_name[64];
-            int j = 0;
-            while (buf[i] && isspace((unsigned char)buf[i])) i++;
-            while (buf[i] && buf[i] != ',' && j < (int)sizeof(var_name)-1) {
-                var_name[j++] = buf[i++];
-            }
-            while (j > 0 && isspace((unsigned char)var_name[j-1])) j--;
-            var_name[j] = '\0';
-            if (j > 0) {
-                set_var_type(var_name, 3); // type 3 = math (store expression string)
-            }
-            if (buf[i] == ',') i++;
-        }
+}
+
+// NAME=value where value is unquoted: copy another variable, or store the
+// literal as a number when it parses as one and as text otherwise
+void assign_value(NVXContext *ctx, const char *name, const char *value) {
+    if (nvx_copy_variable(ctx, name, value)) return;
+    long long iv; double dv;
+    switch (parse_number_literal(value, &iv, &dv)) {
+    case VAL_INT: nvx_set_variable_int(ctx, name, iv); break;
+    case VAL_DOUBLE: nvx_set_variable_number(ctx, name, dv); break;
+    default: nvx_set_variable(ctx, name, value); break;
+    }
+}
+
+// NAME=math(expr); a bare variable name evaluates the expression stored in it
+void assign_math(NVXContext *ctx, const char *name, const char *expr) {
+    double res;
+    if (is_identifier(expr)) {
+        const char *varval = nvx_get_variable(ctx, expr);
+        if (!varval) { printf("NVD Error: Undefined variable for math().\n"); return; }
+        if (!nvx_evaluate_math(ctx, varval, &res)) { printf("NVD Error: Invalid math expression.\n"); return; }
+    } else {
+        if (!nvx_evaluate_math(ctx, expr, &res)) { printf("NVD Error: Invalid math expression.\n"); return; }
+    }
+    nvx_set_variable_number(ctx, name, res);
+}
+
+// math(expr) prints the result, math(lhs=expr) assigns it to lhs
+void execute_math(NVXContext *ctx, const char *lhs, const char *expr) {
+    double res;
+    if (lhs) {
+        if (!nvx_evaluate_math(ctx, expr, &res)) { printf("NVD Error: Invalid math expression.\n"); return; }
+        nvx_set_variable_number(ctx, lhs, res);
         return;
     }
-    if (strncmp(line, "delay=", 6) == 0) {
-        char *val = line + 6;
-        char valcopy[64];
-        strncpy(valcopy, val, sizeof(valcopy)-1); valcopy[sizeof(valcopy)-1] = '\0';
-        trim(valcopy);
-        int delay_val = atoi(valcopy);
-        if (delay_val >= 0) script_delay = delay_val;
+    if (nvx_evaluate_math(ctx, expr, &res)) {
+        print_number(res);
+        printf("\n");
         return;
     }
-    char *equals = NULL;
-    int in_quotes = 0;
-    for (char *p = line; *p; p++) {
-        if (*p == '"') in_quotes = !in_quotes;
-        else if (*p == '=' && !in_quotes) { equals = p; break; }
-    }
-    if (equals) {
-        *equals = '\0';
-        char namebuf[64]; char valuebuf[256];
-        strncpy(namebuf, line, sizeof(namebuf)-1); namebuf[sizeof(namebuf)-1] = '\0';
-        strncpy(valuebuf, equals + 1, sizeof(valuebuf)-1); valuebuf[sizeof(valuebuf)-1] = '\0';
-        trim(namebuf); trim(valuebuf);
-
-        if (strncmp(valuebuf, "sys.command(", 12) == 0) {
-            char *p = strchr(valuebuf, '(');
-            if (p) {
-                p++;
-                char *q = strrchr(p, ')');
-                if (q) *q = '\0';
-                char cmdbuf[512]; strncpy(cmdbuf, p, sizeof(cmdbuf)-1); cmdbuf[sizeof(cmdbuf)-1] = '\0'; trim(cmdbuf);
-                size_t cl = strlen(cmdbuf);
-                if (cl >= 2 && cmdbuf[0] == '"' && cmdbuf[cl-1] == '"') { cmdbuf[cl-1] = '\0'; memmove(cmdbuf, cmdbuf+1, strlen(cmdbuf)); }
-                int rc = execute_sys_command(cmdbuf);
-                char rcbuf[64]; snprintf(rcbuf, sizeof(rcbuf), "%d", rc);
-                set_variable(namebuf, rcbuf);
-                return;
+    printf("NVD Error: Invalid math statement.\n");
+}
+
+// math.map(expr, infile, outfile): infile is CSV with a header row naming the
+// input variables; every row is evaluated and outfile gets one result per line
+void execute_math_map(NVXContext *ctx, const char *expr, const char *infile, const char *outfile) {
+    size_t len;
+    char *data = read_file(infile, &len);
+    if (!data) { printf("NVD Error: Could not open file %s\n", infile); return; }
+    NVXExpr *compiled = nvx_expr_compile(ctx, expr);
+    if (!compiled) { printf("NVD Error: Invalid math expression.\n"); free(data); return; }
+    // header: column names, split in place
+    char *p = data;
+    int ncols = 1;
+    for (char *q = p; *q && *q != '\n'; ++q) if (*q == ',') ncols++;
+    const char **names = nvx_calloc((size_t)ncols, sizeof(char *));
+    double **columns = nvx_calloc((size_t)ncols, sizeof(double *));
+    size_t rows = 0, cap = 0;
+    double *out = NULL;
+    int ok = (names && columns);
+    for (int c = 0; ok && c < ncols; ++c) {
+        char *end = p + strcspn(p, ",\n");
+        char sep = *end;
+        *end = '\0';
+        trim(p);
+        names[c] = p;
+        p = sep ? end + 1 : end;
+    }
+    int line = 1;
+    while (ok && *p) {
+        line++;
+        while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+        if (*p == '\n') { p++; continue; }
+        if (rows == cap) {
+            cap = cap ? cap * 2 : 1024;
+            for (int c = 0; c < ncols && ok; ++c) {
+                double *grown = nvx_realloc(columns[c], cap * sizeof(double));
+                if (grown) columns[c] = grown;
+                else ok = 0;
             }
+            if (!ok) { printf("NVD Error: Out of memory while reading %s\n", infile); break; }
         }
-        // HTTP helper calls
-        if (strncmp(valuebuf, "nvx.http_get(", 13) == 0 || strncmp(valuebuf, "nvx.http_post(", 14) == 0) {
-            int isPost = (strncmp(valuebuf, "nvx.http_post(", 14) == 0);
-            char *p = strchr(valuebuf, '(');
-            if (p) {
+        for (int c = 0; c < ncols; ++c) {
+            char *end;
+            columns[c][rows] = strtod(p, &end);
+            if (end == p) { printf("NVD Error: Bad number in %s line %d.\n", infile, line); ok = 0; break; }
+            p = end;
+            while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+            if (c + 1 < ncols) {
+                if (*p != ',') { printf("NVD Error: Missing column in %s line %d.\n", infile, line); ok = 0; break; }
                 p++;
-                char *q = strrchr(p, ')');
-                if (q) *q = '\0';
-                // split on comma outside quotes
-                char url[1024] = "";
-                char body[2048] = "";
-                int inq = 0; int idx = -1;
-                for (int i = 0; p[i]; i++) {
-                    if (p[i] == '"') inq = !inq;
-                    if (p[i] == ',' && !inq) { idx = i; break; }
-                }
-                if (idx >= 0) {
-                    strncpy(url, p, idx); url[idx] = '\0';
-                    strncpy(body, p + idx + 1, sizeof(body)-1); body[sizeof(body)-1] = '\0';
-                } else {
-                    strncpy(url, p, sizeof(url)-1); url[sizeof(url)-1] = '\0';
-                }
-                trim(url); trim(body);
-                // remove surrounding quotes
-                if (url[0] == '"' && url[strlen(url)-1] == '"') {
-                    memmove(url, url+1, strlen(url));
-                    url[strlen(url)-1] = '\0';
-                }
-                if (body[0] == '"' && body[strlen(body)-1] == '"') {
-                    memmove(body, body+1, strlen(body));
-                    body[strlen(body)-1] = '\0';
-                }
-                char resp[4096] = "";
-                int rc;
-                if (isPost) rc = nvx_http_post(url, body, resp, sizeof(resp));
-                else rc = nvx_http_get(url, resp, sizeof(resp));
-                if (rc >= 0) {
-                    set_variable(namebuf, resp);
-                    set_var_type(namebuf, 2); // mark as string so print() won't treat as numeric expression
-                }
-                return;
             }
         }
-        // JSON helper call
-        if (strncmp(valuebuf, "nvx.json_get(", 13) == 0) {
-            char *p = strchr(valuebuf, '(');
-            if (p) {
-                p++;
-                char *q = strrchr(p, ')');
-                if (q) *q = '\0';
-                // split into json and key
-                char jsonstr[2048] = "";
-                char keystr[256] = "";
-                int inq = 0; int idx = -1;
-                for (int i = 0; p[i]; i++) {
-                    if (p[i] == '"') inq = !inq;
-                    if (p[i] == ',' && !inq) { idx = i; break; }
-                }
-                if (idx >= 0) {
-                    strncpy(jsonstr, p, idx); jsonstr[idx] = '\0';
-                    strncpy(keystr, p + idx + 1, sizeof(keystr)-1); keystr[sizeof(keystr)-1] = '\0';
-                } else {
-                    strncpy(jsonstr, p, sizeof(jsonstr)-1); jsonstr[sizeof(jsonstr)-1] = '\0';
-                }
-                trim(jsonstr); trim(keystr);
-                if (jsonstr[0]=='\"' && jsonstr[strlen(jsonstr)-1]=='\"') {
-                    memmove(jsonstr,jsonstr+1,strlen(jsonstr));
-                    jsonstr[strlen(jsonstr)-1]='\0';
-                } else {
-                    const char *vv = get_variable(jsonstr);
-                    if (vv) {
-                        strncpy(jsonstr, vv, sizeof(jsonstr)-1);
-                        jsonstr[sizeof(jsonstr)-1] = '\0';
-                    }
-                }
-                if (keystr[0]=='\"' && keystr[strlen(keystr)-1]=='\"') {
-                    memmove(keystr,keystr+1,strlen(keystr));
-                    keystr[strlen(keystr)-1]='\0';
-                }
-                char outbuf[1024] = "";
-                if (nvx_json_get(jsonstr, keystr, outbuf, sizeof(outbuf))) {
-                    set_variable(namebuf, outbuf);
-                    set_var_type(namebuf, 2);
-                }
-                return;
+        if (!ok) break;
+        if (*p && *p != '\n') { printf("NVD Error: Extra data in %s line %d.\n", infile, line); ok = 0; break; }
+        if (*p) p++;
+        rows++;
+    }
+    if (ok) {
+        out = nvx_malloc((rows ? rows : 1) * sizeof(double));
+        ok = out && nvx_expr_eval_batch(ctx, compiled, names, (const double **)columns, ncols, rows, out);
+    }
+    if (ok) {
+        FILE *f = fopen(outfile, "w");
+        if (!f) {
+            printf("NVD Error: Could not open file %s\n", outfile);
+        } else {
+            char buf[64];
+            for (size_t r = 0; r < rows; ++r) {
+                nvx_format_number(out[r], buf, sizeof(buf));
+                fputs(buf, f);
+                fputc('\n', f);
             }
+            fclose(f);
         }
-        int input_mode = 0; 
-        if (strncmp(valuebuf, "user.input_var(", 15) == 0 || strncmp(valuebuf, "input_var(", 10) == 0) input_mode = 1;
-        else if (strncmp(valuebuf, "user.input_str(", 15) == 0 || strncmp(valuebuf, "input_str(", 10) == 0) input_mode = 2;
-        else if (strncmp(valuebuf, "user.input(", 11) == 0 || strncmp(valuebuf, "input(", 6) == 0) input_mode = 2;
-        else if (strncmp(valuebuf, "user.input_math(", 16) == 0 || strncmp(valuebuf, "input_math(", 11) == 0) input_mode = 3;
-        if (strncmp(valuebuf, "user.choice_var(", 16) == 0 || strncmp(valuebuf, "choice_var(", 11) == 0) input_mode = 4;
-        if (strncmp(valuebuf, "user.choice_str(", 16) == 0 || strncmp(valuebuf, "choice_str(", 11) == 0) input_mode = 5;
-        if (input_mode) {
-            char *p = strchr(valuebuf, '(');
-            char prompt[200] = "";
-            if (p) {
-                p++;
-                char *q = strrchr(p, ')');
-                if (q) *q = '\0';
-                strncpy(prompt, p, sizeof(prompt)-1); prompt[sizeof(prompt)-1] = '\0';
-                trim(prompt);
-                size_t plen = strlen(prompt);
-                if (plen >= 2 && prompt[0] == '"' && prompt[plen-1] == '"') {
-                    prompt[plen-1] = '\0';
-                    memmove(prompt, prompt+1, strlen(prompt));
-                }
-            }
-            if (input_mode == 4 || input_mode == 5) {
-                char argsbuf[512];
-                strncpy(argsbuf, p, sizeof(argsbuf)-1); argsbuf[sizeof(argsbuf)-1] = '\0';
-                char *args[64]; int nargs = 0;
-                char token[256]; int tpos = 0; int inq = 0;
-                for (int ii = 0;; ii++) {
-                    char ch = argsbuf[ii];
-                    if (ch == '\0' || (ch == ',' && !inq)) {
-                        token[tpos] = '\0';
-                        trim(token);
-                        args[nargs] = strdup(token);
-                        nargs++;
-                        tpos = 0;
-                        if (ch == '\0') break;
-                    } else {
-                        if (ch == '"') inq = !inq;
-                        if (tpos < (int)sizeof(token)-1) token[tpos++] = ch;
-                    }
-                }
-                char local_prompt[200] = ">";
-                if (nargs > 0) {
-                    strncpy(local_prompt, args[0], sizeof(local_prompt)-1); local_prompt[sizeof(local_prompt)-1] = '\0';
-                    size_t lp = strlen(local_prompt);
-                    if (lp >= 2 && local_prompt[0] == '"' && local_prompt[lp-1] == '"') { local_prompt[lp-1] = '\0'; memmove(local_prompt, local_prompt+1, strlen(local_prompt)); }
-                }
-                printf("%s\n", local_prompt); fflush(stdout);
-                for (int oi = 1; oi < nargs; oi++) { printf("%d) %s\n", oi, args[oi]); }
-                printf("Choose: "); fflush(stdout);
-                char input_buffer[200];
-                if (!fgets(input_buffer, sizeof(input_buffer), stdin)) input_buffer[0] = '\0';
-                input_buffer[strcspn(input_buffer, "\n")] = 0;
-                trim(input_buffer);
-                int chosen_index = -1;
-                if (strlen(input_buffer) > 0 && isdigit((unsigned char)input_buffer[0])) chosen_index = atoi(input_buffer);
-                if (chosen_index > 0 && chosen_index < nargs) {
-                    char *opt = args[chosen_index]; char tmpopt[200]; strncpy(tmpopt, opt, sizeof(tmpopt)-1); tmpopt[sizeof(tmpopt)-1] = '\0'; trim(tmpopt);
-                    if (tmpopt[0] == '"') { size_t lp = strlen(tmpopt); if (lp >= 2 && tmpopt[lp-1] == '"') { tmpopt[lp-1] = '\0'; memmove(tmpopt, tmpopt+1, strlen(tmpopt)); } }
-                    set_variable(namebuf, tmpopt);
-                } else {
-                    int matched = 0;
-                    for (int oi = 1; oi < nargs; oi++) {
-                        char *opt = args[oi]; char tmpopt[200]; strncpy(tmpopt, opt, sizeof(tmpopt)-1); tmpopt[sizeof(tmpopt)-1] = '\0'; trim(tmpopt);
-                        if (tmpopt[0] == '"') { size_t lp = strlen(tmpopt); if (lp >= 2 && tmpopt[lp-1] == '"') { tmpopt[lp-1] = '\0'; memmove(tmpopt, tmpopt+1, strlen(tmpopt)); } }
-                        if (strcmp(tmpopt, input_buffer) == 0) { set_variable(namebuf, tmpopt); matched = 1; break; }
-                    }
-                    if (!matched) set_variable(namebuf, input_buffer);
-                }
-                for (int ii = 0; ii < nargs; ii++) free(args[ii]);
-                do_delay();
-                return;
-            }
-            printf("%s", prompt[0] ? prompt : ">" ); fflush(stdout);
-            char input_buffer[200];
-            if (!fgets(input_buffer, sizeof(input_buffer), stdin)) input_buffer[0] = '\0';
-            input_buffer[strcspn(input_buffer, "\n")] = 0;
-            if (input_mode == 1) {
-                char *endptr;
-                double v = strtod(input_buffer, &endptr);
-                int ok = (endptr != input_buffer);
-                while (ok && *endptr) { if (!isspace((unsigned char)*endptr)) { ok = 0; break; } endptr++; }
-                if (ok) {
-                    char numbuf[128];
-                    if (fabs(v - round(v)) < 1e-9) snprintf(numbuf, sizeof(numbuf), "%lld", (long long)llround(v));
-                    else snprintf(numbuf, sizeof(numbuf), "%g", v);
-                    set_variable(namebuf, numbuf);
-                } else {
-                    set_variable(namebuf, input_buffer);
-                }
-            } else {
-                set_variable(namebuf, input_buffer);
-            }
-            do_delay();
-            return;
+    }
+    for (int c = 0; columns && c < ncols; ++c) free(columns[c]);
+    free(columns);
+    free(names);
+    free(out);
+    nvx_expr_free(compiled);
+    free(data);
+}
+
+void assign_sys_command(NVXContext *ctx, const char *name, const char *cmd) {
+    int rc = execute_sys_command(cmd);
+    if (name) nvx_set_variable_int(ctx, name, rc);
+}
+
+// sys.spawn/sys.output options: "shell" runs the command through the shell,
+// "capture" collects stdout and stderr for sys.wait
+static int process_flags(const char *options) {
+    int flags = 0;
+    if (options && strstr(options, "shell")) flags |= NVX_PROC_SHELL;
+    if (options && strstr(options, "capture")) flags |= NVX_PROC_CAPTURE;
+    return flags;
+}
+
+// captured output is stored as a string without its trailing line breaks
+static void set_output(NVXContext *ctx, const char *name, char *out, size_t len) {
+    while (len && (out[len-1] == '\n' || out[len-1] == '\r')) out[--len] = '\0';
+    nvx_set_variable(ctx, name, out);
+    nvx_set_var_type(ctx, name, 2);
+}
+
+// NAME=sys.output(cmd[, options]): run to completion and keep what it printed
+void assign_sys_output(NVXContext *ctx, const char *name, const char *cmd, const char *options) {
+    char *out = NULL;
+    size_t len = 0;
+    nvx_process_run(cmd, process_flags(options) | NVX_PROC_CAPTURE, &out, &len);
+    set_output(ctx, name, out ? out : (char *)"", out ? len : 0);
+    free(out);
+}
+
+// [NAME=]sys.spawn(cmd[, options]): start without waiting, NAME gets the handle
+void assign_spawn(NVXContext *ctx, const char *name, const char *cmd, const char *options) {
+    int h = nvx_process_spawn(cmd, process_flags(options));
+    if (name) nvx_set_variable_int(ctx, name, h);
+}
+
+// [NAME=]sys.wait(handle[, OUT]): NAME gets the exit code, OUT the captured output
+void execute_wait(NVXContext *ctx, const char *name, const char *handle, const char *outvar) {
+    double h;
+    if (!nvx_get_variable_number(ctx, handle, &h)) h = atof(handle);
+    char *out = NULL;
+    size_t len = 0;
+    int rc = nvx_process_wait((int)h, outvar ? &out : NULL, &len);
+    if (outvar) set_output(ctx, outvar, out ? out : (char *)"", out ? len : 0);
+    free(out);
+    if (name) nvx_set_variable_int(ctx, name, rc);
+}
+
+// [NAME=]sys.wait_all(): NAME gets the number of processes that failed
+void execute_wait_all(NVXContext *ctx, const char *name) {
+    int failed = nvx_process_wait_all();
+    if (name) nvx_set_variable_int(ctx, name, failed);
+}
+
+// body == NULL issues a GET, otherwise a POST
+void assign_http(NVXContext *ctx, const char *name, const char *url, const char *body) {
+    char *resp = nvx_http_fetch(body ? "POST" : "GET", url, body, NULL);
+    if (resp) {
+        nvx_set_variable(ctx, name, resp);
+        nvx_set_var_type(ctx, name, 2); // mark as string so print() won't treat as numeric expression
+        free(resp);
+    }
+}
+
+// NAME=nvx.http_get_many(url, ...): the requests run concurrently. NAME_1,
+// NAME_2, ... receive the bodies in argument order ("" for a failed request)
+// and NAME the number of requests that failed.
+void assign_http_many(NVXContext *ctx, const char *name, const char **urls, int n) {
+    NVXArenaMark m = nvx_arena_mark(&ctx->arena);
+    char **bodies = nvx_arena_alloc(&ctx->arena, (size_t)n * sizeof(char *));
+    size_t size = strlen(name) + 16;
+    char *var = nvx_arena_alloc(&ctx->arena, size);
+    if (!bodies || !var) { nvx_arena_release(&ctx->arena, m); return; }
+    int failed = nvx_http_get_many(urls, n, HTTP_MANY_PARALLEL, HTTP_MANY_TIMEOUT_MS, bodies, NULL);
+    for (int i = 0; i < n; ++i) {
+        if (!bodies[i]) printf("NVD Error: nvx.http_get_many: request %d (%s) failed.\n", i + 1, urls[i] ? urls[i] : "unset variable");
+        snprintf(var, size, "%s_%d", name, i + 1);
+        nvx_set_variable(ctx, var, bodies[i] ? bodies[i] : "");
+        nvx_set_var_type(ctx, var, 2);
+        free(bodies[i]);
+    }
+    nvx_set_variable_int(ctx, name, failed);
+    nvx_arena_release(&ctx->arena, m);
+}
+
+static int file_sink(const char *data, size_t len, void *ctx) {
+    return fwrite(data, 1, len, (FILE *)ctx) != len;
+}
+
+// stream a response body to a file; name (if any) receives the byte count
+void execute_http_download(NVXContext *ctx, const char *name, const char *url, const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f) { printf("NVD Error: cannot write '%s'.\n", path); return; }
+    long long n = nvx_http_stream("GET", url, NULL, file_sink, f);
+    if (fclose(f) != 0 && n >= 0) n = -1;
+    if (n < 0) { printf("NVD Error: download of '%s' failed.\n", url); return; }
+    if (name) nvx_set_variable_int(ctx, name, n);
+}
+
+static int json_sink(const char *data, size_t len, void *ctx) {
+    return nvx_json_stream_feed((NVXJsonStream *)ctx, data, len); // stop once the value is complete
+}
+
+// look up key in a JSON response as it arrives, without buffering the body
+void assign_http_json(NVXContext *ctx, const char *name, const char *url, const char *key) {
+    char outbuf[1024] = "";
+    NVXJsonStream js;
+    nvx_json_stream_init(&js, key, outbuf, sizeof(outbuf));
+    if (nvx_http_stream("GET", url, NULL, json_sink, &js) >= 0 && nvx_json_stream_finish(&js)) {
+        nvx_set_variable(ctx, name, outbuf);
+        nvx_set_var_type(ctx, name, 2);
+    }
+}
+
+void assign_json_get(NVXContext *ctx, const char *name, const char *json, int json_is_literal, const char *key) {
+    if (!json_is_literal) {
+        const char *vv = nvx_get_variable(ctx, json);
+        if (vv) json = vv;
+    }
+    char outbuf[1024] = "";
+    if (nvx_json_get(json, key, outbuf, sizeof(outbuf))) {
+        nvx_set_variable(ctx, name, outbuf);
+        nvx_set_var_type(ctx, name, 2);
+    }
+}
+
+// input modes: 1=input_var, 2=input_str/input, 3=input_math, 4=choice_var, 5=choice_str
+void assign_input(NVXContext *ctx, const char *name, int mode, const char *args) {
+    if (mode == 4 || mode == 5) {
+        // prompt first, then the options; counted, then copied into scratch memory
+        NVXArenaMark m = nvx_arena_mark(&ctx->arena);
+        NVXSpan all = { args, strlen(args) }, rest = all, arg[2];
+        int nargs = 0, n;
+        while ((n = nvx_lex_split_args(rest.start, rest.len, arg, 2)) > 0) {
+            nargs++;
+            if (n < 2) break;
+            rest = arg[1];
         }
-        if (strncmp(valuebuf, "math.vars(", 10) == 0 || strncmp(valuebuf, "math(", 5) == 0) {
-            char *p = strchr(valuebuf, '(');
-            if (p) {
-                p++;
-                char *q = strrchr(p, ')');
-                if (q) *q = '\0';
-                char *eq = strchr(p, '=');
-                if (eq) {
-                    *eq = '\0';
-                    char lhs[64]; char rhs[256];
-                    strncpy(lhs, p, sizeof(lhs)-1); lhs[sizeof(lhs)-1] = '\0';
-                    strncpy(rhs, eq+1, sizeof(rhs)-1); rhs[sizeof(rhs)-1] = '\0';
-                    trim(lhs); trim(rhs);
-                    double res;
-                    if (!evaluate_math_expr(rhs, &res)) { printf("NVD Error: Invalid math expression.\n"); return; }
-                    char outbuf[100];
-                    if (fabs(res - round(res)) < 1e-9) snprintf(outbuf, sizeof(outbuf), "%lld", (long long)llround(res));
-                    else snprintf(outbuf, sizeof(outbuf), "%g", res);
-                    set_variable(lhs, outbuf);
-                    return;
-                } else {
-                    char exprbuf[512];
-                    strncpy(exprbuf, p, sizeof(exprbuf)-1); exprbuf[sizeof(exprbuf)-1] = '\0';
-                    trim(exprbuf);
-                    int is_simple_var = 0;
-                    if (exprbuf[0] && (isalpha((unsigned char)exprbuf[0]) || exprbuf[0] == '_')) {
-                        is_simple_var = 1;
-                        for (size_t k = 1; k < strlen(exprbuf); k++) {
-                            if (!isalnum((unsigned char)exprbuf[k]) && exprbuf[k] != '_') { is_simple_var = 0; break; }
-                        }
-                    }
-                    double res;
-                    if (is_simple_var) {
-                        const char *varval = get_variable(exprbuf);
-                        if (!varval) { printf("NVD Error: Undefined variable for math().\n"); return; }
-                        if (!evaluate_math_expr(varval, &res)) { printf("NVD Error: Invalid math expression.\n"); return; }
-                    } else {
-                        if (!evaluate_math_expr(exprbuf, &res)) { printf("NVD Error: Invalid math expression.\n"); return; }
-                    }
-                    char outbuf[100];
-                    if (fabs(res - round(res)) < 1e-9) snprintf(outbuf, sizeof(outbuf), "%lld", (long long)llround(res));
-                    else snprintf(outbuf, sizeof(outbuf), "%g", res);
-                    set_variable(namebuf, outbuf);
-                    return;
-                }
+        char **opts = nvx_arena_alloc(&ctx->arena, (size_t)(nargs ? nargs : 1) * sizeof(char *));
+        if (!opts) return;
+        rest = all;
+        for (int oi = 0; oi < nargs; oi++) {
+            n = nvx_lex_split_args(rest.start, rest.len, arg, 2);
+            NVXSpan opt = nvx_span_unquote(arg[0]);
+            opts[oi] = nvx_arena_strndup(&ctx->arena, opt.start, opt.len);
+            if (!opts[oi]) { nvx_arena_release(&ctx->arena, m); return; }
+            if (n > 1) rest = arg[1];
+        }
+        printf("%s\n", nargs > 0 ? opts[0] : ">"); fflush(stdout);
+        for (int oi = 1; oi < nargs; oi++) { printf("%d) %s\n", oi, opts[oi]); }
+        printf("Choose: "); fflush(stdout);
+        char input_buffer[200];
+        if (!fgets(input_buffer, sizeof(input_buffer), stdin)) input_buffer[0] = '\0';
+        input_buffer[strcspn(input_buffer, "\n")] = 0;
+        trim(input_buffer);
+        int chosen_index = -1;
+        if (strlen(input_buffer) > 0 && isdigit((unsigned char)input_buffer[0])) chosen_index = atoi(input_buffer);
+        if (chosen_index > 0 && chosen_index < nargs) {
+            nvx_set_variable(ctx, name, opts[chosen_index]);
+        } else {
+            int matched = 0;
+            for (int oi = 1; oi < nargs; oi++) {
+                if (strcmp(opts[oi], input_buffer) == 0) { nvx_set_variable(ctx, name, opts[oi]); matched = 1; break; }
             }
+            if (!matched) nvx_set_variable(ctx, name, input_buffer);
         }
-        size_t vlen = strlen(valuebuf);
-        if (vlen >= 2 && valuebuf[0] == '"' && valuebuf[vlen-1] == '"') {
-            valuebuf[vlen-1] = '\0';
-            set_variable(namebuf, valuebuf + 1);
+        nvx_arena_release(&ctx->arena, m);
+        return;
+    }
+    NVXSpan prompt = { args, strlen(args) };
+    prompt = nvx_span_unquote(nvx_span_trim(prompt));
+    if (prompt.len) printf("%.*s", (int)prompt.len, prompt.start);
+    else printf(">");
+    fflush(stdout);
+    char input_buffer[200];
+    if (!fgets(input_buffer, sizeof(input_buffer), stdin)) input_buffer[0] = '\0';
+    input_buffer[strcspn(input_buffer, "\n")] = 0;
+    if (mode == 1) {
+        char *endptr;
+        double v = strtod(input_buffer, &endptr);
+        int ok = (endptr != input_buffer);
+        while (ok && *endptr) { if (!isspace((unsigned char)*endptr)) { ok = 0; break; } endptr++; }
+        if (ok) {
+            nvx_set_variable_number(ctx, name, v);
             return;
         }
-        const char *oth = get_variable(valuebuf);
-        if (oth) { set_variable(namebuf, oth); return; }
-        set_variable(namebuf, valuebuf);
+    }
+    nvx_set_variable(ctx, name, input_buffer);
+}
+
+// goto for a block that the running program did not define itself (e.g. one
+// defined by an earlier `run` in the shell): compile the stored body and run it
+void execute_goto(NVXContext *ctx, const char *name) {
+    NVXProgram *prog = find_named_block(ctx, name);
+    if (!prog) {
+        printf("NVD Error: Undefined label '%s'.\n", name);
+        return;
+    }
+    nvx_program_run(prog);
+}
+
+// Script routes. nvx.route registers a named block for a path; nvx.serve
+// clones the serving context once per server worker (variables and named
+// blocks, compiled in the clone) before the first request. A request then
+// only stores its body in the route's input variable and its path
+// parameters in variables of the same names, runs the worker's compiled
+// block and sends the output variable.
+typedef struct { char *block, *bodyvar, *respvar; } ScriptRoute;
+
+static ScriptRoute **script_routes = NULL;
+static int script_route_count = 0;
+static NVXContext **worker_ctxs = NULL;
+static int worker_ctx_count = 0;
+static _Thread_local NVXContext *worker_ctx = NULL;
+
+static void route_worker_init(int worker) {
+    worker_ctx = worker < worker_ctx_count ? worker_ctxs[worker] : NULL;
+}
+
+static void script_route_handler(const NVXHttpRequest *req, NVXHttpResponse *res, void *data) {
+    const ScriptRoute *r = data;
+    const NVXParams *params = &req->params;
+    NVXContext *ctx = worker_ctx;
+    NVXProgram *prog = ctx ? find_named_block(ctx, r->block) : NULL;
+    if (!prog) {
+        printf("NVD Error: nvx.route: no block '%s' for this worker.\n", r->block);
+        nvx_response_status(res, 500);
         return;
     }
-    if (strncmp(line, "math.vars", 9) == 0 && (line[9] == '(' || isspace((unsigned char)line[9]) || line[9] == '\0')) {
-        execute_math(line);
+    nvx_set_variable(ctx, r->bodyvar, req->body.ptr);
+    nvx_set_var_type(ctx, r->bodyvar, 2);
+    nvx_set_variable(ctx, r->respvar, "");
+    for (int i = 0; i < params->count; ++i) {
+        const NVXParam *pp = &params->items[i];
+        char *value = nvx_arena_strndup(&ctx->arena, pp->value, pp->value_len);
+        if (!value) continue;
+        nvx_set_variable(ctx, pp->name, value);
+        nvx_set_var_type(ctx, pp->name, 2);
+    }
+    nvx_program_run(prog);
+    nvx_arena_reset(&ctx->arena);
+    const char *out = nvx_get_variable(ctx, r->respvar);
+    if (out) nvx_response_write(res, out, strlen(out));
+}
+
+// path is a route pattern, optionally preceded by a method: "GET /users/:id"
+void execute_route(NVXContext *ctx, const char *path, const char *block, const char *bodyvar, const char *respvar) {
+    (void)ctx; // the block is looked up in each worker's clone
+    char method[16] = "";
+    const char *pattern = path;
+    if (path[0] != '/') {
+        size_t mlen = strcspn(path, " ");
+        if (mlen < sizeof(method)) {
+            memcpy(method, path, mlen);
+            method[mlen] = '\0';
+            pattern = path + mlen;
+            while (*pattern == ' ') pattern++;
+        }
+    }
+    if (pattern[0] != '/') {
+        printf("NVD Error: nvx.route: path '%s' must begin with '/'.\n", path);
         return;
     }
-    if (strncmp(line, "math", 4) == 0 && (line[4] == '(' || isspace((unsigned char)line[4]) || line[4] == '\0')) {
-        execute_math(line);
+    ScriptRoute *r = malloc(sizeof(ScriptRoute));
+    ScriptRoute **rs = realloc(script_routes, (size_t)(script_route_count + 1) * sizeof(ScriptRoute *));
+    if (!r || !rs) { free(r); printf("NVD Error: Out of memory.\n"); return; }
+    script_routes = rs;
+    r->block = strdup(block);
+    r->bodyvar = strdup(bodyvar);
+    r->respvar = strdup(respvar);
+    if (!r->block || !r->bodyvar || !r->respvar) {
+        free(r->block); free(r->bodyvar); free(r->respvar); free(r);
+        printf("NVD Error: Out of memory.\n");
         return;
     }
-    if (strncmp(line, "print", 5) == 0) {
-        execute_print(line);
+    if (nvx_add_route(method[0] ? method : NULL, pattern, script_route_handler, r) < 0) {
+        printf("NVD Error: nvx.route: invalid route or route already defined: '%s'.\n", path);
+        free(r->block); free(r->bodyvar); free(r->respvar); free(r);
         return;
     }
-    if (strncmp(line, "goto ", 5) == 0) {
-        char name[64]; strncpy(name, line + 5, sizeof(name)-1); name[sizeof(name)-1] = '\0'; trim(name);
-        const char *body = find_named_block_body(name);
-        if (!body) {
-            printf("NVD Error: Undefined label '%s'.\n", name);
+    script_routes[script_route_count++] = r;
+}
+
+// prefix and dir may be literals or variables holding them
+void execute_static(NVXContext *ctx, const char *prefix, const char *dir) {
+    const char *p = nvx_get_variable(ctx, prefix);
+    const char *d = nvx_get_variable(ctx, dir);
+    if (!p) p = prefix;
+    if (!d) d = dir;
+    if (p[0] != '/') {
+        printf("NVD Error: nvx.static: prefix '%s' must begin with '/'.\n", p);
+        return;
+    }
+    if (nvx_serve_static(p, d) < 0) printf("NVD Error: nvx.static: '%s' is already routed.\n", p);
+}
+
+void execute_serve(NVXContext *ctx, const char *port) {
+    const char *p = nvx_get_variable(ctx, port);
+    if (!p) p = port;
+    for (int i = 0; i < script_route_count; ++i) {
+        if (!find_named_block(ctx, script_routes[i]->block)) {
+            printf("NVD Error: nvx.route: undefined block '%s'.\n", script_routes[i]->block);
             return;
         }
-        FILE *tmp = tmpfile();
-        if (!tmp) {
-            printf("NVD Error: Could not open temporary buffer for goto.\n");
-            return;
+    }
+    int n = nvx_server_worker_count();
+    worker_ctxs = calloc((size_t)n, sizeof(NVXContext *));
+    for (int i = 0; worker_ctxs && i < n; ++i) {
+        if (!(worker_ctxs[i] = nvx_context_clone(ctx))) break;
+        worker_ctx_count++;
+    }
+    if (worker_ctx_count < n) {
+        printf("NVD Error: nvx.serve: could not prepare %d workers.\n", n);
+    } else {
+        nvx_set_worker_init(route_worker_init);
+        if (nvx_run_server(p) < 0) printf("NVD Error: nvx.serve: could not listen on port %s.\n", p);
+        nvx_set_worker_init(NULL);
+    }
+    for (int i = 0; i < worker_ctx_count; ++i) nvx_context_free(worker_ctxs[i]);
+    free(worker_ctxs);
+    worker_ctxs = NULL;
+    worker_ctx_count = 0;
+}
+
+// Conditions are compiled once into a small tree. Leaves are comparisons
+// `left OP right`, split at the first of == != <= >= < > = outside strings.
+// Both sides numeric compares numbers, otherwise == and != compare the text
+// (variables replaced by their value, quoted literals taken as written). A leaf
+// without an operator tests the value for non-zero or non-empty. Above the
+// leaves, `||` binds loosest, then `&&`, then a `!` in front of a comparison or
+// a parenthesised group; && and || stop as soon as the result is known.
+enum { COND_TRUTH, COND_EQ, COND_NE, COND_LE, COND_GE, COND_LT, COND_GT, COND_SET_EQ,
+       COND_AND, COND_OR, COND_NOT };
+
+struct NVXCond {
+    int op;
+    NVXExpr *left, *right;   // leaf sides, NULL when a side does not parse as an expression
+    char *ltext, *rtext;
+    int lquoted, rquoted;    // side was a "..." literal: compare the text, no variable lookup
+    NVXCond *a, *b;          // operands of && || (b unused for !)
+};
+
+// start of the first operator token op outside parentheses in s, or NULL
+static const char *find_top_level(NVXSpan s, const char *op) {
+    NVXLexer lx;
+    nvx_lex_init(&lx, s.start, s.len);
+    NVXLexToken t;
+    int depth = 0;
+    while ((t = nvx_lex_next(&lx)).kind != LEX_END) {
+        if (t.kind == LEX_LPAREN) depth++;
+        else if (t.kind == LEX_RPAREN) depth--;
+        else if (depth == 0 && t.kind == LEX_OP && nvx_lex_is(&t, op)) return t.start;
+    }
+    return NULL;
+}
+
+static char *cond_side(NVXSpan s, int *quoted) {
+    s = nvx_span_trim(s);
+    NVXLexer lx;
+    nvx_lex_init(&lx, s.start, s.len);
+    NVXLexToken t = nvx_lex_next(&lx);
+    *quoted = (t.kind == LEX_STRING && t.len == s.len && s.len >= 2 && s.start[s.len-1] == '"');
+    return nvx_span_dup(*quoted ? nvx_span_unquote(s) : s);
+}
+
+static NVXCond *compile_leaf(NVXContext *ctx, NVXCond *c, NVXSpan all) {
+    static const char *ops[] = {"==","!=","<=",">=","<",">","=", NULL};
+    static const int codes[] = {COND_EQ, COND_NE, COND_LE, COND_GE, COND_LT, COND_GT, COND_SET_EQ};
+    c->op = COND_TRUTH;
+    NVXSpan left = all, right = { all.start + all.len, 0 };
+    NVXLexer lx;
+    nvx_lex_init(&lx, all.start, all.len);
+    NVXLexToken t;
+    while (c->op == COND_TRUTH && (t = nvx_lex_next(&lx)).kind != LEX_END) {
+        if (t.kind != LEX_OP) continue;
+        for (int i = 0; ops[i]; i++) {
+            if (!nvx_lex_is(&t, ops[i])) continue;
+            c->op = codes[i];
+            left.len = (size_t)(t.start - all.start);
+            right.start = t.start + t.len;
+            right.len = (size_t)(all.start + all.len - right.start);
+            break;
         }
-        fwrite(body, 1, strlen(body), tmp);
-        rewind(tmp);
-        interpret_stream(tmp, NULL, 1);
-        fclose(tmp);
-        return;
     }
-    if (strncmp(line, "sys.command(", 12) == 0) {
-        char *p = strchr(line, '(');
-        if (p) {
-            p++;
-            char *q = strrchr(p, ')');
-            if (q) *q = '\0';
-            char cmdbuf[512]; strncpy(cmdbuf, p, sizeof(cmdbuf)-1); cmdbuf[sizeof(cmdbuf)-1] = '\0'; trim(cmdbuf);
-            size_t cl = strlen(cmdbuf);
-            if (cl >= 2 && cmdbuf[0] == '"' && cmdbuf[cl-1] == '"') { cmdbuf[cl-1] = '\0'; memmove(cmdbuf, cmdbuf+1, strlen(cmdbuf)); }
-            execute_sys_command(cmdbuf);
+    c->ltext = cond_side(left, &c->lquoted);
+    c->rtext = cond_side(right, &c->rquoted);
+    if (!c->ltext || !c->rtext) { nvx_cond_free(c); return NULL; }
+    if (!c->lquoted) c->left = nvx_expr_compile(ctx, c->ltext);
+    if (c->op != COND_TRUTH && !c->rquoted) c->right = nvx_expr_compile(ctx, c->rtext);
+    return c;
+}
+
+static NVXCond *compile_span(NVXContext *ctx, NVXSpan s) {
+    s = nvx_span_trim(s);
+    NVXCond *c = nvx_calloc(1, sizeof(NVXCond));
+    if (!c) return NULL;
+    static const struct { const char *text; int op; } logic[] = { {"||", COND_OR}, {"&&", COND_AND} };
+    for (int i = 0; i < 2; i++) {
+        const char *at = find_top_level(s, logic[i].text);
+        if (!at) continue;
+        NVXSpan l = { s.start, (size_t)(at - s.start) };
+        NVXSpan r = { at + 2, (size_t)(s.start + s.len - at - 2) };
+        c->op = logic[i].op;
+        c->a = compile_span(ctx, l);
+        c->b = compile_span(ctx, r);
+        if (!c->a || !c->b) { nvx_cond_free(c); return NULL; }
+        return c;
+    }
+    if (s.len && s.start[0] == '!' && (s.len < 2 || s.start[1] != '=')) {
+        NVXSpan r = { s.start + 1, s.len - 1 };
+        c->op = COND_NOT;
+        c->a = compile_span(ctx, r);
+        if (!c->a) { nvx_cond_free(c); return NULL; }
+        return c;
+    }
+    if (nvx_span_is_group(s)) {
+        NVXSpan inner = { s.start + 1, s.len - 2 };
+        free(c);
+        return compile_span(ctx, inner);
+    }
+    return compile_leaf(ctx, c, s);
+}
+
+NVXCond *nvx_cond_compile(NVXContext *ctx, const char *cond) {
+    NVXSpan s = { cond, strlen(cond) };
+    return compile_span(ctx, s);
+}
+
+void nvx_cond_free(NVXCond *c) {
+    if (!c) return;
+    nvx_cond_free(c->a);
+    nvx_cond_free(c->b);
+    nvx_expr_free(c->left);
+    nvx_expr_free(c->right);
+    free(c->ltext);
+    free(c->rtext);
+    free(c);
+}
+
+static const char *cond_text(NVXContext *ctx, const char *text, int quoted) {
+    const char *v = quoted ? NULL : nvx_get_variable(ctx, text);
+    return v ? v : text;
+}
+
+int nvx_cond_eval(NVXContext *ctx, const NVXCond *c) {
+    switch (c->op) {
+    case COND_AND: return nvx_cond_eval(ctx, c->a) && nvx_cond_eval(ctx, c->b);
+    case COND_OR: return nvx_cond_eval(ctx, c->a) || nvx_cond_eval(ctx, c->b);
+    case COND_NOT: return !nvx_cond_eval(ctx, c->a);
+    }
+    double a, b;
+    int anum = c->left && nvx_expr_eval(ctx, c->left, &a);
+    if (c->op == COND_TRUTH) {
+        if (anum) return fabs(a) > 1e-9;
+        if (c->lquoted) return c->ltext[0] != '\0';
+        const char *s = nvx_get_variable(ctx, c->ltext);
+        return s && s[0] != '\0';
+    }
+    int bnum = c->right && nvx_expr_eval(ctx, c->right, &b);
+    if (anum && bnum) {
+        switch (c->op) {
+        case COND_EQ: case COND_SET_EQ: return fabs(a-b) < 1e-9;
+        case COND_NE: return fabs(a-b) >= 1e-9;
+        case COND_LE: return a <= b;
+        case COND_GE: return a >= b;
+        case COND_LT: return a < b;
+        case COND_GT: return a > b;
         }
+        return 0;
+    }
+    if (c->op != COND_EQ && c->op != COND_NE) return 0;
+    const char *lv = cond_text(ctx, c->ltext, c->lquoted);
+    const char *rv = cond_text(ctx, c->rtext, c->rquoted);
+    return (strcmp(lv, rv) == 0) == (c->op == COND_EQ);
+}
+
+int nvx_eval_condition(NVXContext *ctx, const char *cond) {
+    NVXCond *c = nvx_cond_compile(ctx, cond);
+    if (!c) return 0;
+    int r = nvx_cond_eval(ctx, c);
+    nvx_cond_free(c);
+    return r;
+}
+
+void nvx_run_source(NVXContext *ctx, const char *src, size_t len) {
+    NVXProgram *prog = nvx_compile_source(ctx, src, len);
+    if (!prog) {
+        printf("NVD Error: Out of memory while compiling script.\n");
         return;
     }
+    nvx_program_run(prog);
+    nvx_program_free(prog);
+    nvx_arena_reset(&ctx->arena);
 }
 
-void run_file(const char *filename) {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
+void nvx_interpret_line(NVXContext *ctx, const char *line) {
+    nvx_run_source(ctx, line, strlen(line));
+}
+
+int nvx_run_file(NVXContext *ctx, const char *filename) {
+    size_t len;
+    int mapped = 0;
+    char *src = map_file(filename, &len, &mapped);
+    if (!src) {
         printf("NVD Error: Could not open file %s\n", filename);
-        exit(1);
+        return -1;
     }
-    have_pushback = 0;
-    interpret_stream(file, NULL, 1);
-    fclose(file);
+    // the program keeps its own copies of every operand: drop the source before running
+    NVXProgram *prog = nvx_compile_source(ctx, src, len);
+    unmap_file(src, len, mapped);
+    if (!prog) {
+        printf("NVD Error: Out of memory while compiling script.\n");
+        return -1;
+    }
+    nvx_program_run(prog);
+    nvx_program_free(prog);
+    nvx_arena_reset(&ctx->arena);
+    return 0;
+}
+
+// default-context forms
+int eval_condition(const char *cond) { return nvx_eval_condition(nvx_default_context(), cond); }
+void run_source(const char *src, size_t len) { nvx_run_source(nvx_default_context(), src, len); }
+void interpret_line_simple(const char *line) { nvx_interpret_line(nvx_default_context(), line); }
+// the command-line entry point: a script that cannot be run ends the process
+void run_file(const char *filename) {
+    if (nvx_run_file(nvx_default_context(), filename) < 0) exit(1);
 }
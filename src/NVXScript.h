@@ -3,20 +3,64 @@
 
 #include <stdio.h>
 
+// Every routine runs against an interpreter context (NVXContext.h). The
+// entry points without one use nvx_default_context(); several contexts may
+// run scripts in parallel, one thread each.
+typedef struct NVXContext NVXContext;
+
 // core interpreter routines
+// run_file exits the process if the file cannot be run; nvx_run_file prints
+// the error and returns -1 instead (0 once the script has run)
 void run_file(const char *filename);
+int nvx_run_file(NVXContext *ctx, const char *filename);
+
+// compile and execute script source held in memory. The run_file and
+// run_source families are top-level entry points: they reset the context's
+// scratch arena when done.
+void run_source(const char *src, size_t len);
+void nvx_run_source(NVXContext *ctx, const char *src, size_t len);
 
 // line-level execution (used by shell)
-void interpret_line_simple(FILE *file, char *line);
+void interpret_line_simple(const char *line);
+void nvx_interpret_line(NVXContext *ctx, const char *line);
 
 // helpers for other modules
 int eval_condition(const char *cond);
+int nvx_eval_condition(NVXContext *ctx, const char *cond);
+
+// a condition parsed once for repeated evaluation (if/while in compiled programs)
+typedef struct NVXCond NVXCond;
+NVXCond *nvx_cond_compile(NVXContext *ctx, const char *cond);
+int nvx_cond_eval(NVXContext *ctx, const NVXCond *c);
+void nvx_cond_free(NVXCond *c);
 void trim(char *s);
 int execute_sys_command(const char *cmd);
-void do_delay(void);
+void do_delay(NVXContext *ctx);
 
-// helpers from requests module
-int nvx_http_get(const char *url, char *response, size_t resp_size);
-int nvx_http_post(const char *url, const char *body, char *response, size_t resp_size);
+// statement handlers, called by the program VM with pre-parsed operands
+void print_literal_arg(NVXContext *ctx, const char *text);
+void print_var_arg(NVXContext *ctx, const char *name);
+void print_expr_arg(NVXContext *ctx, const char *expr);
+void print_help(NVXContext *ctx);
+void declare_variables(NVXContext *ctx, const char *list, int type);
+void assign_value(NVXContext *ctx, const char *name, const char *value);
+void assign_math(NVXContext *ctx, const char *name, const char *expr);
+void execute_math(NVXContext *ctx, const char *lhs, const char *expr);
+void execute_math_map(NVXContext *ctx, const char *expr, const char *infile, const char *outfile);
+void assign_sys_command(NVXContext *ctx, const char *name, const char *cmd);
+void assign_sys_output(NVXContext *ctx, const char *name, const char *cmd, const char *options);
+void assign_spawn(NVXContext *ctx, const char *name, const char *cmd, const char *options);
+void execute_wait(NVXContext *ctx, const char *name, const char *handle, const char *outvar);
+void execute_wait_all(NVXContext *ctx, const char *name);
+void assign_http(NVXContext *ctx, const char *name, const char *url, const char *body);
+void assign_http_many(NVXContext *ctx, const char *name, const char **urls, int n);
+void execute_http_download(NVXContext *ctx, const char *name, const char *url, const char *path);
+void assign_http_json(NVXContext *ctx, const char *name, const char *url, const char *key);
+void assign_json_get(NVXContext *ctx, const char *name, const char *json, int json_is_literal, const char *key);
+void assign_input(NVXContext *ctx, const char *name, int mode, const char *args);
+void execute_goto(NVXContext *ctx, const char *name);
+void execute_route(NVXContext *ctx, const char *path, const char *block, const char *bodyvar, const char *respvar);
+void execute_static(NVXContext *ctx, const char *prefix, const char *dir);
+void execute_serve(NVXContext *ctx, const char *port);
 
 #endif // NVX_SCRIPT_H
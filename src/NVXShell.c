@@ -1,6 +1,8 @@
 #include "NVXShell.h"
 #include "NVXVars.h"
+#include "NVXContext.h"
 #include "NVXScript.h"
+#include "NVXArena.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -11,29 +13,39 @@ static void print_shell_help(void) {
     printf("  exec <command>  - execute system command\n");
     printf("  vars            - list variables and values\n");
     printf("  types           - list declared variable types\n");
+    printf("  mem             - show interpreter allocation counters\n");
     printf("  help, ?         - show this help\n");
     printf("  quit, exit      - leave the shell\n");
 }
 
-static void list_variables(void) {
-    if (variable_count == 0) { printf("(no variables)\n"); return; }
-    for (int i = 0; i < variable_count; ++i) {
-        printf("%s = %s\n", variables[i].name, variables[i].value);
+static void list_variables(NVXContext *ctx) {
+    int shown = 0;
+    for (int i = 0; i < ctx->var_count; ++i) {
+        const char *value = nvx_var_text(ctx, i);
+        if (!value) continue;
+        printf("%s = %s\n", ctx->vars[i].name, value);
+        shown++;
     }
+    if (!shown) printf("(no variables)\n");
 }
 
-static void list_var_types(void) {
-    if (type_count == 0) { printf("(no declared types)\n"); return; }
-    for (int i = 0; i < type_count; ++i) {
+static void list_var_types(NVXContext *ctx) {
+    int shown = 0;
+    for (int i = 0; i < ctx->var_count; ++i) {
+        const Variable *v = &ctx->vars[i];
+        if (!v->type) continue;
         const char *tname = "unknown";
-        if (var_types[i].type == 1) tname = "numeric";
-        else if (var_types[i].type == 2) tname = "string";
-        else if (var_types[i].type == 3) tname = "math-expr";
-        printf("%s : %s\n", var_types[i].name, tname);
+        if (v->type == 1) tname = "numeric";
+        else if (v->type == 2) tname = "string";
+        else if (v->type == 3) tname = "math-expr";
+        printf("%s : %s\n", v->name, tname);
+        shown++;
     }
+    if (!shown) printf("(no declared types)\n");
 }
 
 void start_shell(void) {
+    NVXContext *ctx = nvx_default_context();
     char line[512];
     while (1) {
         printf("NVD> "); fflush(stdout);
@@ -43,17 +55,18 @@ void start_shell(void) {
         if (strlen(line) == 0) continue;
         if (strcmp(line, "quit") == 0 || strcmp(line, "exit") == 0) break;
         if (strcmp(line, "help") == 0 || strcmp(line, "?") == 0) { print_shell_help(); continue; }
-        if (strcmp(line, "vars") == 0) { list_variables(); continue; }
-        if (strcmp(line, "types") == 0) { list_var_types(); continue; }
+        if (strcmp(line, "vars") == 0) { list_variables(ctx); continue; }
+        if (strcmp(line, "types") == 0) { list_var_types(ctx); continue; }
+        if (strcmp(line, "mem") == 0) { nvx_alloc_report(); continue; }
         if (strncmp(line, "run ", 4) == 0) {
             char *fn = line + 4; trim(fn);
-            if (*fn) run_file(fn);
+            if (*fn) nvx_run_file(ctx, fn);
             else printf("Usage: run <filename>\n");
             continue;
         }
         if (strncmp(line, "source ", 7) == 0) {
             char *fn = line + 7; trim(fn);
-            if (*fn) run_file(fn);
+            if (*fn) nvx_run_file(ctx, fn);
             else printf("Usage: source <filename>\n");
             continue;
         }
@@ -64,7 +77,7 @@ void start_shell(void) {
             } else printf("Usage: exec <system-command>\n");
             continue;
         }
-        interpret_line_simple(NULL, line);
-        do_delay();
+        nvx_interpret_line(ctx, line);
+        do_delay(ctx);
     }
 }
\ No newline at end of file
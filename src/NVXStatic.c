@@ -0,0 +1,304 @@
+#include "NVXStatic.h"
+#include "NVXNet.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#define strcasecmp _stricmp
+#else
+#include <strings.h>
+#include <pthread.h>
+#include <unistd.h>
+#define O_BINARY 0
+#endif
+#ifndef S_ISDIR
+#define S_ISDIR(m) (((m) & S_IFMT) == S_IFDIR)
+#define S_ISREG(m) (((m) & S_IFMT) == S_IFREG)
+#endif
+
+typedef struct { char *dir; } Mount;
+
+// Cache entries sit in a hash table by file name and in a list ordered by
+// use, most recent first; the tail is dropped when the total is exceeded.
+typedef struct CacheEntry {
+    char *path;
+    char *data; size_t size;
+    long long version;                 // modification time the data was read at
+    struct CacheEntry *prev, *next;    // use order
+    struct CacheEntry *chain;          // hash bucket
+} CacheEntry;
+
+#define CACHE_BUCKETS 1024
+
+static CacheEntry *buckets[CACHE_BUCKETS];
+static CacheEntry *lru_head, *lru_tail;
+static size_t cache_total = 0;
+static size_t cache_max_file = 64 * 1024;
+static size_t cache_max_total = 16 * 1024 * 1024;
+
+#ifdef _WIN32
+// the Windows server handles one request at a time
+#define cache_lock()
+#define cache_unlock()
+#else
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define cache_lock() pthread_mutex_lock(&cache_mutex)
+#define cache_unlock() pthread_mutex_unlock(&cache_mutex)
+#endif
+
+// modification time with the best resolution the platform reports
+static long long file_version(const struct stat *st) {
+#ifdef __linux__
+    return (long long)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+#else
+    return (long long)st->st_mtime;
+#endif
+}
+
+static size_t hash_path(const char *s) {
+    size_t h = 2166136261u; // FNV-1a
+    for (; *s; ++s) {
+        h ^= (unsigned char)*s;
+        h *= 16777619u;
+    }
+    return h & (CACHE_BUCKETS - 1);
+}
+
+static void lru_unlink(CacheEntry *e) {
+    if (e->prev) e->prev->next = e->next;
+    else lru_head = e->next;
+    if (e->next) e->next->prev = e->prev;
+    else lru_tail = e->prev;
+    e->prev = e->next = NULL;
+}
+
+static void lru_push(CacheEntry *e) {
+    e->prev = NULL;
+    e->next = lru_head;
+    if (lru_head) lru_head->prev = e;
+    else lru_tail = e;
+    lru_head = e;
+}
+
+static void cache_remove(CacheEntry *e) {
+    CacheEntry **pp = &buckets[hash_path(e->path)];
+    while (*pp != e) pp = &(*pp)->chain;
+    *pp = e->chain;
+    lru_unlink(e);
+    cache_total -= e->size;
+    free(e->path);
+    free(e->data);
+    free(e);
+}
+
+static CacheEntry *cache_find(const char *path) {
+    for (CacheEntry *e = buckets[hash_path(path)]; e; e = e->chain) {
+        if (strcmp(e->path, path) == 0) return e;
+    }
+    return NULL;
+}
+
+// copy the cached contents of path into res if they are still current
+static int cache_get(const char *path, const struct stat *st, NVXHttpResponse *res) {
+    int hit = 0;
+    cache_lock();
+    CacheEntry *e = cache_find(path);
+    if (e && (e->version != file_version(st) || e->size != (size_t)st->st_size)) {
+        cache_remove(e); // changed on disk
+        e = NULL;
+    }
+    if (e) {
+        lru_unlink(e);
+        lru_push(e);
+        hit = nvx_response_write(res, e->data, e->size) == 0;
+    }
+    cache_unlock();
+    return hit;
+}
+
+// take ownership of data as the contents of path
+static void cache_put(const char *path, const struct stat *st, char *data, size_t size) {
+    CacheEntry *e = malloc(sizeof(CacheEntry));
+    char *name = strdup(path);
+    if (!e || !name) { free(e); free(name); free(data); return; }
+    e->path = name;
+    e->data = data;
+    e->size = size;
+    e->version = file_version(st);
+    cache_lock();
+    CacheEntry *old = cache_find(path); // another worker may have read it too
+    if (old) cache_remove(old);
+    size_t b = hash_path(path);
+    e->chain = buckets[b];
+    buckets[b] = e;
+    lru_push(e);
+    cache_total += size;
+    while (cache_total > cache_max_total && lru_tail) cache_remove(lru_tail);
+    cache_unlock();
+}
+
+void nvx_static_cache(size_t max_file, size_t max_total) {
+    cache_lock();
+    cache_max_file = max_total ? max_file : 0;
+    cache_max_total = max_file ? max_total : 0;
+    while (cache_total > cache_max_total && lru_tail) cache_remove(lru_tail);
+    cache_unlock();
+}
+
+static const struct { const char *ext, *type; } mime_types[] = {
+    { "html", "text/html; charset=utf-8" }, { "htm", "text/html; charset=utf-8" },
+    { "css", "text/css; charset=utf-8" }, { "js", "text/javascript; charset=utf-8" },
+    { "json", "application/json" }, { "txt", "text/plain; charset=utf-8" },
+    { "csv", "text/csv; charset=utf-8" }, { "xml", "application/xml" },
+    { "svg", "image/svg+xml" }, { "png", "image/png" }, { "jpg", "image/jpeg" },
+    { "jpeg", "image/jpeg" }, { "gif", "image/gif" }, { "ico", "image/x-icon" },
+    { "webp", "image/webp" }, { "wasm", "application/wasm" }, { "pdf", "application/pdf" },
+};
+
+static const char *mime_type(const char *path) {
+    const char *dot = strrchr(path, '.');
+    if (dot && !strchr(dot, '/')) {
+        for (size_t i = 0; i < sizeof(mime_types) / sizeof(mime_types[0]); ++i) {
+            if (strcasecmp(dot + 1, mime_types[i].ext) == 0) return mime_types[i].type;
+        }
+    }
+    return "application/octet-stream";
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c = (char)tolower((unsigned char)c);
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+// dir + '/' + the percent-decoded request path; 0 if the path is unsafe or too long
+static int file_path(const Mount *m, const char *rel, size_t len, char *out, size_t size) {
+    size_t n = (size_t)snprintf(out, size, "%s/", m->dir);
+    if (n >= size) return 0;
+    size_t seg = n; // start of the current segment
+    for (size_t i = 0; i < len; ++i) {
+        char c = rel[i];
+        if (c == '%' && i + 2 < len && hex_digit(rel[i+1]) >= 0 && hex_digit(rel[i+2]) >= 0) {
+            c = (char)(hex_digit(rel[i+1]) * 16 + hex_digit(rel[i+2]));
+            i += 2;
+        }
+        if (c == '\0' || c == '\\') return 0;
+        if (c == '/') {
+            if (n - seg == 2 && out[seg] == '.' && out[seg+1] == '.') return 0;
+            if (n == seg) continue; // empty segment
+            seg = n + 1;
+        }
+        if (n + 1 >= size) return 0;
+        out[n++] = c;
+    }
+    if (n - seg == 2 && out[seg] == '.' && out[seg+1] == '.') return 0;
+    out[n] = '\0';
+    return 1;
+}
+
+static void http_date(time_t t, char *buf, size_t size) {
+    struct tm tm;
+#ifdef _WIN32
+    gmtime_s(&tm, &t);
+#else
+    gmtime_r(&t, &tm);
+#endif
+    strftime(buf, size, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+}
+
+// If-None-Match is "*" or a list of tags; ours is quoted, so a substring
+// match cannot hit a different tag
+static int etag_matches(const NVXHttpSpan *inm, const char *etag) {
+    size_t n = strlen(etag);
+    if (inm->len == 1 && inm->ptr[0] == '*') return 1;
+    for (size_t i = 0; i + n <= inm->len; ++i) {
+        if (memcmp(inm->ptr + i, etag, n) == 0) return 1;
+    }
+    return 0;
+}
+
+static char *read_file(int fd, size_t size) {
+    char *data = malloc(size ? size : 1);
+    size_t got = 0;
+    while (data && got < size) {
+        long r = (long)read(fd, data + got, (unsigned)(size - got));
+        if (r <= 0) { free(data); return NULL; }
+        got += (size_t)r;
+    }
+    return data;
+}
+
+static void static_handler(const NVXHttpRequest *req, NVXHttpResponse *res, void *data) {
+    const Mount *m = data;
+    size_t rel_len = 0;
+    const char *rel = nvx_param_get(&req->params, "path", &rel_len);
+    char path[4096];
+    struct stat st;
+    if (!file_path(m, rel ? rel : "", rel_len, path, sizeof(path)) || stat(path, &st) < 0) {
+        nvx_response_status(res, 404);
+        return;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        size_t n = strlen(path);
+        const char *index = n && path[n-1] == '/' ? "index.html" : "/index.html";
+        if (n + strlen(index) >= sizeof(path)) { nvx_response_status(res, 404); return; }
+        strcpy(path + n, index);
+        if (stat(path, &st) < 0) { nvx_response_status(res, 404); return; }
+    }
+    if (!S_ISREG(st.st_mode)) {
+        nvx_response_status(res, 404);
+        return;
+    }
+    char etag[64], modified[64];
+    snprintf(etag, sizeof(etag), "\"%llx-%llx\"", (unsigned long long)st.st_size,
+             (unsigned long long)file_version(&st));
+    http_date(st.st_mtime, modified, sizeof(modified));
+    nvx_response_header(res, "ETag", etag);
+    nvx_response_header(res, "Last-Modified", modified);
+    const NVXHttpSpan *inm = nvx_request_header(req, "If-None-Match");
+    if (inm && etag_matches(inm, etag)) {
+        nvx_response_status(res, 304);
+        return;
+    }
+    nvx_response_type(res, mime_type(path));
+    size_t size = (size_t)st.st_size;
+    int small = cache_max_file && size <= cache_max_file;
+    if (small && cache_get(path, &st, res)) return;
+    int fd = open(path, O_RDONLY | O_BINARY);
+    if (fd < 0) {
+        nvx_response_status(res, 404);
+        return;
+    }
+    if (small) {
+        char *contents = read_file(fd, size);
+        close(fd);
+        if (!contents) { nvx_response_status(res, 500); return; }
+        nvx_response_write(res, contents, size);
+        cache_put(path, &st, contents, size);
+        return;
+    }
+    nvx_response_file(res, fd, 0, size);
+}
+
+int nvx_serve_static(const char *prefix, const char *dir) {
+    Mount *m = malloc(sizeof(Mount));
+    size_t plen = strlen(prefix);
+    char *pattern = malloc(plen + 8);
+    if (!m || !pattern || !(m->dir = strdup(dir))) { free(m); free(pattern); return -1; }
+    size_t dlen = strlen(m->dir);
+    while (dlen > 1 && m->dir[dlen-1] == '/') m->dir[--dlen] = '\0';
+    while (plen > 0 && prefix[plen-1] == '/') plen--;
+    memcpy(pattern, prefix, plen);
+    strcpy(pattern + plen, "/*path");
+    int rc = nvx_add_route("GET", pattern, static_handler, m);
+    if (rc == 0) rc = nvx_add_route("HEAD", pattern, static_handler, m);
+    free(pattern);
+    // on failure m may already be registered for GET, so it is kept
+    return rc;
+}
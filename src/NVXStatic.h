@@ -0,0 +1,25 @@
+#ifndef NVX_STATIC_H
+#define NVX_STATIC_H
+
+#include <stddef.h>
+
+// static files for the NVXNet server. A mount answers GET and HEAD requests
+// below a URL prefix with the files of a directory: Content-Type from the
+// extension, Content-Length, Last-Modified and an ETag built from size and
+// modification time. A request whose If-None-Match holds the current ETag
+// gets 304. A directory is answered with its index.html. Paths containing
+// ".." are refused.
+//
+// Small files are kept in memory, least recently used dropped first. Each
+// request still stats the file, and an entry whose size or modification time
+// changed is read again. Larger files go out with sendfile(2).
+
+// prefix is the URL path ("/" or e.g. "/dash"), dir the directory it maps to.
+// Call before nvx_run_server; returns 0, or -1 if the route cannot be added.
+int nvx_serve_static(const char *prefix, const char *dir);
+
+// files up to max_file bytes are cached, max_total bytes in all; 0 for
+// either turns the cache off (defaults: 64 KB and 16 MB)
+void nvx_static_cache(size_t max_file, size_t max_total);
+
+#endif // NVX_STATIC_H
@@ -1,87 +1,294 @@
 #include "NVXVars.h"
+#include "NVXContext.h"
+#include "NVXProgram.h"
+#include "NVXArena.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 
-// variable storage defined in header
-Variable variables[100];
-int variable_count = 0;
+// Per context: variable slots indexed by interned name, and an open-addressing
+// index from name to slot (linear probing, -1 = empty, size is a power of two
+// kept at most half full).
 
-VarType var_types[100];
-int type_count = 0;
+// Named blocks (for `void name { ... }` and `goto name`). version changes on
+// every store, so a definition passed again by the same program is a no-op.
+// body keeps the source so the block can be compiled into another context.
+typedef struct NVXNamedBlock { char *name; char *body; NVXProgram *prog; unsigned version; } NamedBlock;
 
-// Named blocks (for `void name { ... }` and `goto name`)
-typedef struct { char name[64]; char *body; } NamedBlock;
-NamedBlock named_blocks[100];
-int named_block_count = 0;
+static size_t hash_name(const char *name, size_t len) {
+    size_t h = 2166136261u; // FNV-1a
+    const unsigned char *p = (const unsigned char *)name;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
 
-int script_delay = -1; // -1 = no delay, 0 = wait for input, >0 seconds delay between statements
+static int rehash(NVXContext *ctx, size_t size) {
+    int *idx = nvx_malloc(size * sizeof(int));
+    if (!idx) return 0;
+    for (size_t i = 0; i < size; ++i) idx[i] = -1;
+    for (int s = 0; s < ctx->var_count; ++s) {
+        size_t h = hash_name(ctx->vars[s].name, strlen(ctx->vars[s].name)) & (size - 1);
+        while (idx[h] >= 0) h = (h + 1) & (size - 1);
+        idx[h] = s;
+    }
+    free(ctx->var_index);
+    ctx->var_index = idx;
+    ctx->var_index_size = size;
+    return 1;
+}
 
-void set_var_type(const char *name, int type) {
-    for (int i = 0; i < type_count; i++) {
-        if (strcmp(var_types[i].name, name) == 0) {
-            var_types[i].type = type;
-            return;
-        }
+int nvx_find_var_slot_n(NVXContext *ctx, const char *name, size_t len) {
+    if (!ctx->var_index) return -1;
+    size_t mask = ctx->var_index_size - 1;
+    size_t h = hash_name(name, len) & mask;
+    while (ctx->var_index[h] >= 0) {
+        const char *vn = ctx->vars[ctx->var_index[h]].name;
+        if (strncmp(vn, name, len) == 0 && vn[len] == '\0') return ctx->var_index[h];
+        h = (h + 1) & mask;
+    }
+    return -1;
+}
+
+int nvx_find_var_slot(NVXContext *ctx, const char *name) {
+    return nvx_find_var_slot_n(ctx, name, strlen(name));
+}
+
+int nvx_var_slot_n(NVXContext *ctx, const char *name, size_t len) {
+    int s = nvx_find_var_slot_n(ctx, name, len);
+    if (s >= 0) return s;
+    if ((size_t)(ctx->var_count + 1) * 2 > ctx->var_index_size) {
+        if (!rehash(ctx, ctx->var_index_size ? ctx->var_index_size * 2 : 64)) return -1;
     }
-    if (type_count < 100) {
-        strcpy(var_types[type_count].name, name);
-        var_types[type_count].type = type;
-        type_count++;
+    if (ctx->var_count == ctx->var_cap) {
+        int ncap = ctx->var_cap ? ctx->var_cap * 2 : 64;
+        Variable *nv = nvx_realloc(ctx->vars, (size_t)ncap * sizeof(Variable));
+        if (!nv) return -1;
+        ctx->vars = nv;
+        ctx->var_cap = ncap;
     }
+    char *interned = nvx_malloc(len + 1);
+    if (!interned) return -1;
+    memcpy(interned, name, len);
+    interned[len] = '\0';
+    s = ctx->var_count++;
+    Variable *v = &ctx->vars[s];
+    v->name = interned;
+    v->type = 0;
+    v->kind = VAL_UNSET;
+    v->text = NULL;
+    v->cap = 0;
+    v->text_ok = 0;
+    size_t h = hash_name(name, len) & (ctx->var_index_size - 1);
+    while (ctx->var_index[h] >= 0) h = (h + 1) & (ctx->var_index_size - 1);
+    ctx->var_index[h] = s;
+    return s;
 }
 
-int get_var_type(const char *name) {
-    for (int i = 0; i < type_count; i++) {
-        if (strcmp(var_types[i].name, name) == 0) {
-            return var_types[i].type;
-        }
+int nvx_var_slot(NVXContext *ctx, const char *name) {
+    return nvx_var_slot_n(ctx, name, strlen(name));
+}
+
+void nvx_set_var_type(NVXContext *ctx, const char *name, int type) {
+    int s = nvx_var_slot(ctx, name);
+    if (s >= 0) ctx->vars[s].type = type;
+}
+
+int nvx_get_var_type(NVXContext *ctx, const char *name) {
+    int s = nvx_find_var_slot(ctx, name);
+    return s >= 0 ? ctx->vars[s].type : 0; // 0 = unknown type
+}
+
+void nvx_format_number(double v, char *buf, size_t size) {
+    if (fabs(v) < 9.2e18 && fabs(v - round(v)) < 1e-9) snprintf(buf, size, "%lld", (long long)llround(v));
+    else snprintf(buf, size, "%.15g", v);
+}
+
+static int store_text(Variable *v, const char *value, size_t len) {
+    if (len + 1 > v->cap) {
+        size_t ncap = v->cap ? v->cap : 32;
+        while (ncap < len + 1) ncap *= 2;
+        char *nb = nvx_realloc(v->text, ncap);
+        if (!nb) return 0;
+        v->text = nb;
+        v->cap = ncap;
     }
-    return 0; // unknown type
+    // value may alias the current contents (e.g. A=A)
+    memmove(v->text, value, len);
+    v->text[len] = '\0';
+    return 1;
 }
 
-void set_variable(const char *name, const char *value) {
-    for (int i = 0; i < variable_count; i++) {
-        if (strcmp(variables[i].name, name) == 0) {
-            strcpy(variables[i].value, value);
-            return;
-        }
+void nvx_set_variable(NVXContext *ctx, const char *name, const char *value) {
+    int s = nvx_var_slot(ctx, name);
+    if (s < 0) return;
+    Variable *v = &ctx->vars[s];
+    if (!store_text(v, value, strlen(value))) return;
+    v->kind = VAL_STRING;
+    v->text_ok = 1;
+}
+
+void nvx_var_set_number(NVXContext *ctx, int slot, double value) {
+    Variable *v = &ctx->vars[slot];
+    v->kind = VAL_DOUBLE;
+    v->num.d = value;
+    v->text_ok = 0;
+}
+
+void nvx_set_variable_number(NVXContext *ctx, const char *name, double value) {
+    int s = nvx_var_slot(ctx, name);
+    if (s >= 0) nvx_var_set_number(ctx, s, value);
+}
+
+void nvx_set_variable_int(NVXContext *ctx, const char *name, long long value) {
+    int s = nvx_var_slot(ctx, name);
+    if (s < 0) return;
+    Variable *v = &ctx->vars[s];
+    v->kind = VAL_INT;
+    v->num.i = value;
+    v->text_ok = 0;
+}
+
+int nvx_copy_variable(NVXContext *ctx, const char *dst, const char *src) {
+    int from = nvx_find_var_slot(ctx, src);
+    if (from < 0 || ctx->vars[from].kind == VAL_UNSET) return 0;
+    int to = nvx_var_slot(ctx, dst);
+    if (to < 0 || to == from) return to >= 0;
+    Variable *d = &ctx->vars[to], *f = &ctx->vars[from]; // after nvx_var_slot, which may move vars
+    if (f->kind == VAL_STRING) {
+        if (!store_text(d, f->text, strlen(f->text))) return 0;
+        d->text_ok = 1;
+    } else {
+        d->num = f->num;
+        d->text_ok = 0;
     }
-    if (variable_count < 100) {
-        strcpy(variables[variable_count].name, name);
-        strcpy(variables[variable_count].value, value);
-        variable_count++;
+    d->kind = f->kind;
+    return 1;
+}
+
+const char *nvx_var_text(NVXContext *ctx, int slot) {
+    Variable *v = &ctx->vars[slot];
+    if (v->kind == VAL_UNSET) return NULL;
+    if (!v->text_ok) {
+        char buf[64];
+        if (v->kind == VAL_INT) snprintf(buf, sizeof(buf), "%lld", v->num.i);
+        else nvx_format_number(v->num.d, buf, sizeof(buf));
+        if (!store_text(v, buf, strlen(buf))) return NULL;
+        v->text_ok = 1;
     }
+    return v->text;
 }
 
-const char* get_variable(const char *name) {
-    for (int i = 0; i < variable_count; i++) {
-        if (strcmp(variables[i].name, name) == 0) {
-            return variables[i].value;
-        }
+int nvx_var_number(NVXContext *ctx, int slot, double *out) {
+    const Variable *v = &ctx->vars[slot];
+    switch (v->kind) {
+    case VAL_DOUBLE: *out = v->num.d; return 1;
+    case VAL_INT: *out = (double)v->num.i; return 1;
+    case VAL_STRING: *out = atof(v->text); return 1;
+    default: return 0;
+    }
+}
+
+const char *nvx_get_variable(NVXContext *ctx, const char *name) {
+    int s = nvx_find_var_slot(ctx, name);
+    return s >= 0 ? nvx_var_text(ctx, s) : NULL;
+}
+
+int nvx_get_variable_number(NVXContext *ctx, const char *name, double *out) {
+    int s = nvx_find_var_slot(ctx, name);
+    return s >= 0 ? nvx_var_number(ctx, s, out) : 0;
+}
+
+// default-context forms
+void set_variable(const char *name, const char *value) { nvx_set_variable(nvx_default_context(), name, value); }
+const char *get_variable(const char *name) { return nvx_get_variable(nvx_default_context(), name); }
+void set_variable_number(const char *name, double value) { nvx_set_variable_number(nvx_default_context(), name, value); }
+void set_variable_int(const char *name, long long value) { nvx_set_variable_int(nvx_default_context(), name, value); }
+int get_variable_number(const char *name, double *out) { return nvx_get_variable_number(nvx_default_context(), name, out); }
+int copy_variable(const char *dst, const char *src) { return nvx_copy_variable(nvx_default_context(), dst, src); }
+void set_var_type(const char *name, int type) { nvx_set_var_type(nvx_default_context(), name, type); }
+int get_var_type(const char *name) { return nvx_get_var_type(nvx_default_context(), name); }
+
+static NamedBlock *lookup_named_block(NVXContext *ctx, const char *name) {
+    for (int i = 0; i < ctx->block_count; ++i) {
+        if (strcmp(ctx->blocks[i].name, name) == 0) return &ctx->blocks[i];
     }
     return NULL;
 }
 
-void store_named_block(const char *name, const char *body) {
-    for (int i = 0; i < named_block_count; ++i) {
-        if (strcmp(named_blocks[i].name, name) == 0) {
-            free(named_blocks[i].body);
-            named_blocks[i].body = strdup(body);
-            return;
+unsigned store_named_block(NVXContext *ctx, const char *name, const char *body, unsigned known) {
+    NamedBlock *nb = lookup_named_block(ctx, name);
+    if (nb && known && nb->version == known) return known; // still the caller's definition
+    NVXProgram *prog = nvx_compile_source(ctx, body, strlen(body));
+    if (!prog) return 0;
+    char *src = nvx_strdup(body);
+    if (!src) { nvx_program_free(prog); return 0; }
+    if (!nb) {
+        if (ctx->block_count == ctx->block_cap) {
+            int ncap = ctx->block_cap ? ctx->block_cap * 2 : 16;
+            NamedBlock *nbs = nvx_realloc(ctx->blocks, (size_t)ncap * sizeof(NamedBlock));
+            if (!nbs) { nvx_program_free(prog); free(src); return 0; }
+            ctx->blocks = nbs;
+            ctx->block_cap = ncap;
         }
+        char *copy = nvx_strdup(name);
+        if (!copy) { nvx_program_free(prog); free(src); return 0; }
+        nb = &ctx->blocks[ctx->block_count++];
+        nb->name = copy;
+    } else {
+        nvx_program_release(nb->prog); // the old body may be the one running
+        free(nb->body);
     }
-    if (named_block_count < 100) {
-        strncpy(named_blocks[named_block_count].name, name, sizeof(named_blocks[named_block_count].name)-1);
-        named_blocks[named_block_count].name[sizeof(named_blocks[named_block_count].name)-1] = '\0';
-        named_blocks[named_block_count].body = strdup(body);
-        named_block_count++;
+    nb->body = src;
+    nb->prog = prog;
+    nb->version = ++ctx->block_version;
+    if (!nb->version) nb->version = ++ctx->block_version; // 0 means none
+    return nb->version;
+}
+
+NVXProgram *find_named_block(NVXContext *ctx, const char *name) {
+    NamedBlock *nb = lookup_named_block(ctx, name);
+    return nb ? nb->prog : NULL;
+}
+
+int nvx_vars_copy(NVXContext *dst, NVXContext *src) {
+    for (int i = 0; i < src->var_count; ++i) {
+        const Variable *f = &src->vars[i];
+        int s = nvx_var_slot(dst, f->name);
+        if (s < 0) return 0;
+        Variable *d = &dst->vars[s];
+        if (f->text_ok && !store_text(d, f->text, strlen(f->text))) return 0;
+        d->type = f->type;
+        d->kind = f->kind;
+        d->num = f->num;
+        d->text_ok = f->text_ok;
+    }
+    for (int i = 0; i < src->block_count; ++i) {
+        if (!store_named_block(dst, src->blocks[i].name, src->blocks[i].body, 0)) return 0;
     }
+    return 1;
 }
 
-const char *find_named_block_body(const char *name) {
-    for (int i = 0; i < named_block_count; ++i) {
-        if (strcmp(named_blocks[i].name, name) == 0) return named_blocks[i].body;
+void nvx_vars_destroy(NVXContext *ctx) {
+    for (int i = 0; i < ctx->var_count; ++i) {
+        free((char *)ctx->vars[i].name);
+        free(ctx->vars[i].text);
     }
-    return NULL;
+    free(ctx->vars);
+    free(ctx->var_index);
+    for (int i = 0; i < ctx->block_count; ++i) {
+        free(ctx->blocks[i].name);
+        free(ctx->blocks[i].body);
+        nvx_program_free(ctx->blocks[i].prog);
+    }
+    free(ctx->blocks);
+    ctx->vars = NULL;
+    ctx->var_count = ctx->var_cap = 0;
+    ctx->var_index = NULL;
+    ctx->var_index_size = 0;
+    ctx->blocks = NULL;
+    ctx->block_count = ctx->block_cap = 0;
 }
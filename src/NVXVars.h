@@ -1,32 +1,74 @@
 #ifndef NVX_VARS_H
 #define NVX_VARS_H
 
-// variable storage and type management used by the interpreter
+#include <stddef.h>
 
-// set and get variable by name (string value)
+// variable storage and type management used by the interpreter. Every
+// variable lives in an interpreter context (NVXContext.h); the functions
+// without a context argument use nvx_default_context().
+typedef struct NVXContext NVXContext;
+
+// set and get variable by name. get_variable returns the text form of the
+// value (numbers are formatted on demand), valid until the variable changes.
 void set_variable(const char *name, const char *value);
 const char* get_variable(const char *name);
+void nvx_set_variable(NVXContext *ctx, const char *name, const char *value);
+const char *nvx_get_variable(NVXContext *ctx, const char *name);
+
+// numeric access without a round trip through text
+void set_variable_number(const char *name, double value);
+void set_variable_int(const char *name, long long value);
+void nvx_set_variable_number(NVXContext *ctx, const char *name, double value);
+void nvx_set_variable_int(NVXContext *ctx, const char *name, long long value);
+// 1 and *out set if the variable exists; string values are read with atof semantics
+int get_variable_number(const char *name, double *out);
+int nvx_get_variable_number(NVXContext *ctx, const char *name, double *out);
+// copy value and kind of src into dst; returns 0 if src is unset
+int copy_variable(const char *dst, const char *src);
+int nvx_copy_variable(NVXContext *ctx, const char *dst, const char *src);
+
+// value kinds a slot can hold
+typedef enum { VAL_UNSET, VAL_STRING, VAL_DOUBLE, VAL_INT } ValueKind;
 
-// storage arrays exposed for shell/debug
-extern int variable_count;
-extern int type_count;
+// Every name is interned once into a slot of its context's `vars`; the slot
+// index is stable for the life of the context, so callers may cache it.
+// type is the declared type (0 until declared), kind the tagged runtime value.
+// text holds string values, or the cached formatting of a number when text_ok.
+typedef struct {
+    const char *name;
+    int type;
+    ValueKind kind;
+    union { double d; long long i; } num;
+    char *text; size_t cap; int text_ok;
+} Variable;
 
-// underlying storage structures are exposed for introspection
-typedef struct { char name[50]; char value[100]; } Variable;
-extern Variable variables[100];
+// slot lookup: nvx_var_slot creates the slot if needed (-1 on allocation
+// failure), nvx_find_var_slot returns -1 for names never seen. The _n forms
+// take a name that is not NUL-terminated (a lexer span).
+int nvx_var_slot(NVXContext *ctx, const char *name);
+int nvx_find_var_slot(NVXContext *ctx, const char *name);
+int nvx_var_slot_n(NVXContext *ctx, const char *name, size_t len);
+int nvx_find_var_slot_n(NVXContext *ctx, const char *name, size_t len);
 
-typedef struct { char name[50]; int type; } VarType;
-extern VarType var_types[100];
+// slot-level accessors used by compiled code
+const char *nvx_var_text(NVXContext *ctx, int slot);
+int nvx_var_number(NVXContext *ctx, int slot, double *out);
+void nvx_var_set_number(NVXContext *ctx, int slot, double value);
+
+// shared number formatting: integral values print without a fraction
+void nvx_format_number(double v, char *buf, size_t size);
 
 // type management: 1=numeric,2=string,3=math-expression
 void set_var_type(const char *name, int type);
 int get_var_type(const char *name);
+void nvx_set_var_type(NVXContext *ctx, const char *name, int type);
+int nvx_get_var_type(NVXContext *ctx, const char *name);
 
-// named block storage (for void/goto)
-void store_named_block(const char *name, const char *body);
-const char *find_named_block_body(const char *name);
-
-// script-wide control
-extern int script_delay;
+// named block storage (for void/goto): bodies are compiled into ctx when
+// stored. store_named_block returns the version stored under name; passing it
+// back as known skips the work while nobody has redefined the block (0 = force).
+struct NVXProgram;
+unsigned store_named_block(NVXContext *ctx, const char *name, const char *body, unsigned known);
+struct NVXProgram *find_named_block(NVXContext *ctx, const char *name);
 
 #endif // NVX_VARS_H